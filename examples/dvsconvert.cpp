@@ -0,0 +1,284 @@
+/*
+ * Converts a recorded raw DVS byte stream (the concatenated bytes of
+ * the bulk transfers, as DVSSensor reads them) into an event array,
+ * one row per event: timestamp (usec), x, y, polarity, all uint32.
+ *
+ * The input is split into chunks that are decoded on all cores. The
+ * decoder state a chunk starts with (reference timestamp, sub
+ * timestamp and column) is found with a first, parallel pass that
+ * records which of those each chunk sets, and then stitched together
+ * in order, so the output is the same as decoding the whole stream
+ * in one go (as long as the stream is word-aligned at chunk starts,
+ * which it is unless it's corrupted; then the chunk resyncs itself).
+ *
+ *   dvsconvert [-j threads] [-f npy|bin] [-c chunk_mb] input output
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "roboflex_dvs/decoder.h"
+
+using namespace roboflex::dvs;
+
+static const char *const short_options = "hj:f:c:";
+static const struct option long_options[] = {
+    { "help",       0,  NULL,   'h' },
+    { "jobs",       1,  NULL,   'j' },
+    { "format",     1,  NULL,   'f' },
+    { "chunk",      1,  NULL,   'c' },
+    { NULL,         0,  NULL,    0  }
+};
+
+static void print_usage(const char* program_name, FILE *stream, int exit_code)
+{
+    fprintf(stream, "Usage: %s [options] input output\n", program_name);
+    fprintf(stream,
+        "  -h  --help        Display this usage information.\n"
+        "  -j  --jobs        Number of threads (default: all cores).\n"
+        "  -f  --format      npy (default) or bin: raw little-endian uint32 rows.\n"
+        "  -c  --chunk       Chunk size in MB (default: 16, at most 2047).\n"
+        "Each output row is: timestamp (usec), x, y, polarity.\n");
+    exit(exit_code);
+}
+
+// Sentinels for "this chunk never set it": real values can't take these.
+static const unsigned int UNSET_TS = UINT_MAX;
+static const int UNSET_POS = INT_MIN;
+
+// Which parts of the decoder state a chunk leaves behind.
+struct ChunkSummary {
+    DVSDecoderState exit_state;
+    bool sets_long_ts = false;
+    bool sets_column = false;
+};
+
+// Runs fn(chunk) for every chunk in [begin, end), on num_threads threads.
+template <typename Fn>
+static void parallel_for(size_t begin, size_t end, int num_threads, Fn fn)
+{
+    std::atomic<size_t> next(begin);
+    auto worker = [&]() {
+        for (size_t i = next++; i < end; i = next++) {
+            fn(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int k=1; k<num_threads; k++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread: threads) {
+        thread.join();
+    }
+}
+
+static std::string npy_header(size_t num_events)
+{
+    std::string dict = "{'descr': '<u4', 'fortran_order': False, 'shape': (" + std::to_string(num_events) + ", 4), }";
+
+    // Magic, version, header length, then the dict padded to 128 bytes
+    // (it's rewritten once the count is known, so it must not change size).
+    std::string header("\x93NUMPY\x01\x00", 8);
+    size_t dict_len = 128 - 10;
+    dict.resize(dict_len - 1, ' ');
+    dict += '\n';
+    header += (char)(dict_len & 0xFF);
+    header += (char)(dict_len >> 8);
+    return header + dict;
+}
+
+int main(int argc, char **argv)
+{
+    int num_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string format = "npy";
+    size_t chunk_size = 16 << 20;
+
+    int next_option;
+    while ((next_option = getopt_long(argc, argv, short_options, long_options, NULL)) != -1) {
+        switch (next_option) {
+            case 'h':
+                print_usage(argv[0], stdout, 0);
+                break;
+            case 'j':
+                num_threads = std::max(1, atoi(optarg));
+                break;
+            case 'f':
+                format = optarg;
+                break;
+            case 'c':
+                chunk_size = std::clamp<size_t>(strtoull(optarg, NULL, 10), 1, INT_MAX >> 20) << 20;
+                break;
+            default:
+                print_usage(argv[0], stderr, 1);
+        }
+    }
+
+    if (argc - optind != 2 || (format != "npy" && format != "bin")) {
+        print_usage(argv[0], stderr, 1);
+    }
+
+    const char* input_filename = argv[optind];
+    const char* output_filename = argv[optind + 1];
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Map the input.
+    int fd = open(input_filename, O_RDONLY);
+    if (fd < 0) {
+        perror(input_filename);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(input_filename);
+        return 1;
+    }
+    size_t num_bytes = st.st_size;
+    const uint8_t* data = nullptr;
+    if (num_bytes > 0) {
+        void* mapped = mmap(NULL, num_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+        madvise(mapped, num_bytes, MADV_SEQUENTIAL);
+        data = static_cast<const uint8_t*>(mapped);
+    }
+
+    // Chunks are whole words, so each one starts word-aligned, and
+    // the decoder takes an int length.
+    chunk_size = std::clamp<size_t>(chunk_size, 4, INT_MAX) / 4 * 4;
+    size_t num_chunks = (num_bytes + chunk_size - 1) / chunk_size;
+    auto chunk_begin = [&](size_t i) { return data + i * chunk_size; };
+    auto chunk_length = [&](size_t i) { return std::min(chunk_size, num_bytes - i * chunk_size); };
+
+    // Pass 1: what each chunk does to the decoder state.
+    std::vector<ChunkSummary> summaries(num_chunks);
+    parallel_for(0, num_chunks, num_threads, [&](size_t i) {
+        DVSDecoderState sentinel;
+        sentinel.longTs = UNSET_TS;
+        sentinel.shortTs = UNSET_TS;
+        sentinel.posX = UNSET_POS;
+
+        DVSDecoder decoder;
+        decoder.reset(sentinel);
+        decoder.decode(chunk_begin(i), chunk_length(i), [](bool, int, int, unsigned int) {});
+
+        ChunkSummary& summary = summaries[i];
+        summary.exit_state = decoder.get_state();
+        summary.sets_long_ts = summary.exit_state.longTs != UNSET_TS;
+        summary.sets_column = summary.exit_state.posX != UNSET_POS;
+    });
+
+    // Stitch: the state each chunk starts in is whatever the chunks
+    // before it last set.
+    std::vector<DVSDecoderState> entry_states(num_chunks);
+    DVSDecoderState state;
+    for (size_t i=0; i<num_chunks; i++) {
+        entry_states[i] = state;
+        const ChunkSummary& summary = summaries[i];
+        if (summary.sets_long_ts) {
+            state.longTs = summary.exit_state.longTs;
+        }
+        if (summary.sets_column) {
+            state.shortTs = summary.exit_state.shortTs;
+            state.posX = summary.exit_state.posX;
+        }
+        state.timeStamp = state.longTs + state.shortTs;
+    }
+
+    FILE* out = fopen(output_filename, "wb");
+    if (out == NULL) {
+        perror(output_filename);
+        return 1;
+    }
+    if (format == "npy") {
+        std::string header = npy_header(0);
+        if (fwrite(header.data(), 1, header.size(), out) != header.size()) {
+            perror(output_filename);
+            return 1;
+        }
+    }
+
+    // Pass 2: decode for real, a wave of chunks at a time, so memory
+    // stays bounded, and write the waves out in order.
+    size_t num_events = 0;
+    DVSDecoderStats totals;
+    std::vector<std::vector<uint32_t>> decoded(num_threads);
+    std::vector<DVSDecoderStats> stats(num_threads);
+
+    for (size_t wave=0; wave<num_chunks; wave+=num_threads) {
+        size_t wave_end = std::min(num_chunks, wave + num_threads);
+
+        parallel_for(wave, wave_end, num_threads, [&](size_t i) {
+            std::vector<uint32_t>& events = decoded[i - wave];
+            events.clear();
+            DVSDecoder decoder;
+            decoder.reset(entry_states[i]);
+            decoder.decode(chunk_begin(i), chunk_length(i), [&](bool pol, int x, int y, unsigned int t) {
+                events.push_back(t);
+                events.push_back(x);
+                events.push_back(y);
+                events.push_back(pol ? 1 : 0);
+            });
+            stats[i - wave] = decoder.get_stats();
+        });
+
+        for (size_t i=wave; i<wave_end; i++) {
+            const std::vector<uint32_t>& events = decoded[i - wave];
+            if (fwrite(events.data(), sizeof(uint32_t), events.size(), out) != events.size()) {
+                perror(output_filename);
+                return 1;
+            }
+            num_events += events.size() / 4;
+            totals.words += stats[i - wave].words;
+            totals.invalid_words += stats[i - wave].invalid_words;
+            totals.resyncs += stats[i - wave].resyncs;
+            totals.bytes_discarded += stats[i - wave].bytes_discarded;
+        }
+    }
+
+    if (format == "npy") {
+        std::string header = npy_header(num_events);
+        if (fseek(out, 0, SEEK_SET) != 0 || fwrite(header.data(), 1, header.size(), out) != header.size()) {
+            perror(output_filename);
+            return 1;
+        }
+    }
+
+    if (fclose(out) != 0) {
+        perror(output_filename);
+        return 1;
+    }
+
+    if (data != nullptr) {
+        munmap(const_cast<uint8_t*>(data), num_bytes);
+    }
+    close(fd);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::cout << input_filename << ": " << num_bytes << " bytes, "
+              << num_chunks << " chunks on " << num_threads << " threads, "
+              << num_events << " events, "
+              << totals.invalid_words << " invalid words, "
+              << totals.resyncs << " resyncs, "
+              << totals.bytes_discarded << " bytes discarded, in "
+              << seconds << " s" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Measures what the MessagePool saves when building DVSEigenData,
+ * against plain make_shared: the average time per message both ways,
+ * for batches of a given number of events (half on, half off).
+ *
+ * Only the message object and its control block come out of the
+ * pool; the payload is allocated by the flexbuffers builder either
+ * way, so the difference is the cost of one allocation, next to the
+ * cost of serializing the events.
+ *
+ *   pool_benchmark [events_per_batch] [num_batches]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "roboflex_dvs/dvs.h"
+
+using namespace roboflex::dvs;
+
+template <typename MakeFn>
+static double nanoseconds_per_message(int num_batches, MakeFn make)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i=0; i<num_batches; i++) {
+        auto message = make(i);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / num_batches;
+}
+
+int main(int argc, char **argv)
+{
+    int events_per_batch = argc > 1 ? std::max(2, atoi(argv[1])) : 64;
+    int num_batches = argc > 2 ? std::max(1, atoi(argv[2])) : 100000;
+
+    int num_on = events_per_batch / 2;
+    int num_off = events_per_batch - num_on;
+    std::vector<unsigned short> on_events(num_on * 2, 1);
+    std::vector<unsigned short> off_events(num_off * 2, 2);
+
+    double heap = nanoseconds_per_message(num_batches, [&](int i) {
+        return std::make_shared<DVSEigenData>(
+            on_events.data(), num_on, off_events.data(), num_off, i, 0.0, 0.0);
+    });
+
+    MessagePool<DVSEigenData> pool;
+    double pooled = nanoseconds_per_message(num_batches, [&](int i) {
+        return pool.make(
+            on_events.data(), num_on, off_events.data(), num_off, i, 0.0, 0.0);
+    });
+
+    BlockPoolStats stats = pool.get_stats();
+    std::cout << events_per_batch << " events per batch, " << num_batches << " batches:" << std::endl
+              << "  make_shared:      " << heap << " ns per message" << std::endl
+              << "  MessagePool:      " << pooled << " ns per message" << std::endl
+              << "  pool hits/misses: " << stats.hits << "/" << stats.misses << std::endl;
+
+    return 0;
+}
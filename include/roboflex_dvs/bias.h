@@ -0,0 +1,167 @@
+#ifndef ROBOFLEX_DVS_BIAS__H
+#define ROBOFLEX_DVS_BIAS__H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+// The sensitivity biases that run_dvs_gen3.txt sets ("decrease
+// sensitivity"), and the values it sets them to: higher values mean
+// fewer events.
+constexpr int DVSBiasSlaveAddress = 0x20;
+constexpr int DVSNumBiasRegisters = 2;
+constexpr int DVSBiasRegisters[DVSNumBiasRegisters] = {0x001C, 0x001E};
+constexpr int DVSBiasDefaults[DVSNumBiasRegisters] = {0x08, 0x00};
+
+/**
+ * Keeps the decoded event rate inside [low_event_rate, high_event_rate]
+ * (events per second) by nudging the sensitivity bias registers.
+ *
+ * The rate is measured over control_period seconds of sensor time.
+ * Only after hold_periods consecutive periods outside the band do
+ * the biases move, by bias_step; and the period right after a change
+ * is ignored, while the sensor settles. Between the band and the
+ * hold, a rate hovering around either edge doesn't make the biases
+ * oscillate.
+ *
+ * The registers don't hold the same value (see run_dvs_gen3.txt), so
+ * each one is moved relative to its own starting value, which is read
+ * from the sensor when the controller is constructed (and throws if
+ * it can't be). Both move by the same offset, each clamped to
+ * [min_bias, max_bias], for as long as either of them still can.
+ * Nothing is written until the rate calls for it. Failed writes are
+ * counted, not thrown: the pipeline keeps running either way.
+ *
+ * This node passes its input through, so it can sit inline.
+ *
+ * expects: DVSEigenData
+ * signals: DVSEigenData (the input, unchanged)
+ */
+class DVSBiasController: public core::Node {
+public:
+    DVSBiasController(
+        std::shared_ptr<DVSRegisterInterface> sensor,
+        double low_event_rate = 200000.0,
+        double high_event_rate = 2000000.0,
+        double control_period = 0.1,
+        int hold_periods = 3,
+        int min_bias = 0x00,
+        int max_bias = 0x3F,
+        int bias_step = 1,
+        const std::string &name = "DVSBiasController");
+
+    void receive(core::MessagePtr m) override;
+
+    // How far the biases have been moved from where they started.
+    int get_bias_offset() const { return bias_offset; }
+    std::vector<int> get_biases() const;
+    const std::vector<int>& get_start_biases() const { return start_biases; }
+
+    double get_event_rate() const { return event_rate; }
+    unsigned long get_num_adjustments() const { return num_adjustments; }
+    unsigned long get_num_write_errors() const { return num_write_errors; }
+
+protected:
+
+    void control(double rate);
+    bool move_biases(int step);
+    int bias_value(int register_index, int offset) const;
+
+    std::shared_ptr<DVSRegisterInterface> sensor;
+    double low_event_rate;
+    double high_event_rate;
+    double control_period;
+    int hold_periods;
+    int min_bias;
+    int max_bias;
+    int bias_step;
+
+    std::vector<int> start_biases;
+    std::atomic<int> bias_offset{0};
+    std::atomic<double> event_rate{0};
+    std::atomic<unsigned long> num_adjustments{0};
+    std::atomic<unsigned long> num_write_errors{0};
+
+    double window_start_t = -1;
+    double last_t = 0;
+    unsigned long window_events = 0;
+    int periods_above = 0;
+    int periods_below = 0;
+    bool settling = false;
+};
+
+/**
+ * A stand-in for DVSSensor, for testing things like the bias
+ * controller without hardware. It streams synthetic Gen3 words, as
+ * DVSRawData in transfers of transfer_size bytes, paced by the wall
+ * clock. The bias registers start at DVSBiasDefaults, and events land
+ * on random pixels at a rate that follows how far the biases have
+ * moved from there (on average over the registers):
+ *
+ *   scene_event_rate * 2^(-bias_offset / bias_halving_step)
+ *
+ * so raising the biases by bias_halving_step halves the rate. Change the
+ * scene rate at any time to simulate the lighting or motion changing.
+ *
+ * start() streams in real time, a millisecond of sensor time per
+ * millisecond of wall clock. Or, without starting it, generate()
+ * produces any number of milliseconds right away, in the calling
+ * thread, which is how tests run minutes of sensor time in seconds.
+ * Don't do both at once.
+ *
+ * expects: nothing
+ * signals: DVSRawData
+ */
+class DVSSimulatedSensor: public core::RunnableNode, public DVSRegisterInterface {
+public:
+    DVSSimulatedSensor(
+        double scene_event_rate = 2000000.0,
+        double bias_halving_step = 2.0,
+        int transfer_size = 1024,
+        const std::string &name = "DVSSimulatedSensor");
+
+    int read_register(int slave_address, int address) override;
+    bool write_register(int slave_address, int address, int value) override;
+
+    void set_scene_event_rate(double rate) { scene_event_rate = rate; }
+    double get_scene_event_rate() const { return scene_event_rate; }
+
+    // The rate the current biases give, in events per second.
+    double get_event_rate() const;
+
+    // Produces num_msec milliseconds of data now, unpaced.
+    void generate(unsigned int num_msec);
+
+    // Milliseconds of sensor time produced so far.
+    uint32_t get_num_msec() const { return num_msec; }
+
+protected:
+    void child_thread_fn() override;
+    void generate_millisecond();
+
+    std::atomic<double> scene_event_rate;
+    double bias_halving_step;
+    int transfer_size;
+
+    std::mt19937 rng{5489};
+    std::vector<uint8_t> words;
+    uint64_t transfer_id = 0;
+    double pending_events = 0;
+    std::atomic<uint32_t> num_msec{0};
+
+    mutable std::mutex registers_mutex;
+    std::map<std::pair<int, int>, int> registers;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_BIAS__H
@@ -0,0 +1,86 @@
+#ifndef ROBOFLEX_DVS_CALIBRATION__H
+#define ROBOFLEX_DVS_CALIBRATION__H
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * Pinhole intrinsics with Brown-Conrady distortion (the same model
+ * and coefficient order as OpenCV: k1, k2, p1, p2, k3), plus an
+ * optional rectifying rotation and new projection, as produced by
+ * stereo rectification.
+ *
+ * This is in image coordinates of the 480 x 320 image that
+ * DVSEigenToGrayScale emits: u is the column (an event's y), and
+ * v is the row (an event's x).
+ *
+ * If new_fx is 0, the new projection is the same as the original.
+ */
+struct DVSCameraCalibration {
+    double fx = 1.0;
+    double fy = 1.0;
+    double cx = 240.0;
+    double cy = 160.0;
+
+    double k1 = 0.0;
+    double k2 = 0.0;
+    double p1 = 0.0;
+    double p2 = 0.0;
+    double k3 = 0.0;
+
+    Eigen::Matrix3d rectification = Eigen::Matrix3d::Identity();
+
+    double new_fx = 0.0;
+    double new_fy = 0.0;
+    double new_cx = 0.0;
+    double new_cy = 0.0;
+};
+
+/**
+ * Per-pixel lookup table, computed once from a DVSCameraCalibration,
+ * that maps each raw (distorted) sensor pixel to its undistorted and
+ * rectified location - both rounded to a pixel, and with subpixel
+ * precision. Pixels that land outside the sensor are invalid.
+ *
+ * Throws std::invalid_argument if fx or fy is not > 0, or if a new
+ * projection is given (new_fx != 0) whose focal lengths are not > 0.
+ */
+class DVSUndistortionTable {
+public:
+    DVSUndistortionTable(const DVSCameraCalibration& calibration);
+
+    const DVSCameraCalibration& get_calibration() const { return calibration; }
+
+    // Rounded output pixel; returns false if the pixel maps off the sensor.
+    inline bool lookup(int x, int y, unsigned short& out_x, unsigned short& out_y) const {
+        int i = 2 * (x * 480 + y);
+        out_x = pixel_table[i];
+        out_y = pixel_table[i+1];
+        return out_x != INVALID;
+    }
+
+    inline void lookup_subpixel(int x, int y, float& out_x, float& out_y) const {
+        int i = 2 * (x * 480 + y);
+        out_x = subpixel_table[i];
+        out_y = subpixel_table[i+1];
+    }
+
+    int get_num_valid() const { return num_valid; }
+
+    static constexpr unsigned short INVALID = 0xFFFF;
+
+protected:
+    DVSCameraCalibration calibration;
+    std::vector<unsigned short> pixel_table;
+    std::vector<float> subpixel_table;
+    int num_valid = 0;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_CALIBRATION__H
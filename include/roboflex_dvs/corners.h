@@ -0,0 +1,89 @@
+#ifndef ROBOFLEX_DVS_CORNERS__H
+#define ROBOFLEX_DVS_CORNERS__H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * Corner events detected on the event stream: one row per corner,
+ * where the first column is x and the second column is y (same
+ * layout as the frames in DVSEigenData). All corners in one message
+ * share the sensor timestamp t of the events that produced them.
+ */
+class DVSCornerData: public core::Message {
+public:
+    inline static const char MessageName[] = "DVSCornerData";
+
+    DVSCornerData(core::Message& other): core::Message(other) {}
+    DVSCornerData(
+        const unsigned short *corner_data, int num_corners,
+        double t, double t0, double t1);
+
+    double get_t() const { return root_val("t").AsDouble(); }
+    double get_t0() const { return root_val("t0").AsDouble(); }
+    double get_t1() const { return root_val("t1").AsDouble(); }
+
+    const DVSEigenData::DVSFrame get_corners() const {
+        return serialization::deserialize_eigen_matrix<unsigned short, Eigen::Dynamic, 2>(root_val("corners"));
+    }
+
+    void print_on(ostream& os) const override;
+};
+
+
+/**
+ * Detects corners directly on the event stream, using the eFAST
+ * detector (Mueggler et al., 2017) on a Surface of Active Events
+ * (SAE): the latest timestamp of each pixel, kept separately per
+ * polarity.
+ *
+ * Every event updates its own pixel of the SAE and then looks for
+ * a contiguous arc of the newest timestamps on the two circles of
+ * radius 3 and 4 around it. That's a bounded amount of work per
+ * event; nothing is ever recomputed over a whole frame.
+ *
+ * Events that fire again at the same pixel and polarity within the
+ * refractory period (in sensor timestamp units) don't update the
+ * SAE and are not tested.
+ *
+ * expects: DVSEigenData
+ * signals: DVSCornerData
+ */
+class DVSCornerDetector: public core::Node {
+public:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> SurfaceOfActiveEvents;
+
+    DVSCornerDetector(
+        double refractory_period = 50000.0,
+        const std::string& name = "DVSCornerDetector");
+
+    void receive(core::MessagePtr m) override;
+
+    unsigned long get_num_events() const { return num_events; }
+    unsigned long get_num_corners() const { return num_corners; }
+
+protected:
+
+    bool process_event(bool polarity, int x, int y, double t);
+    bool has_streak(const SurfaceOfActiveEvents& sae, int x, int y, const int circle[][2], int circle_size, int min_streak, int max_streak) const;
+
+    double refractory_period;
+
+    SurfaceOfActiveEvents sae_on;
+    SurfaceOfActiveEvents sae_off;
+
+    std::vector<unsigned short> current_corners;
+
+    unsigned long num_events = 0;
+    unsigned long num_corners = 0;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_CORNERS__H
@@ -0,0 +1,360 @@
+#ifndef ROBOFLEX_DVS_DECODER__H
+#define ROBOFLEX_DVS_DECODER__H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * Everything a Gen3 decoder carries from one word to the next:
+ * the reference timestamp, the sub-timestamp, and the current
+ * column (which becomes an event's x). With this, any buffer of
+ * words can be decoded on its own.
+ */
+struct DVSDecoderState {
+	unsigned int longTs = 0; // * 10 usec
+	unsigned int shortTs = 0; // * 1 msec
+	unsigned int timeStamp = 0; // * usec
+	int posX = 0;
+};
+
+// The reference timestamp is 22 bits of milliseconds, so sensor time
+// (in usec) wraps around every 2^22 msec: about every 70 minutes.
+constexpr double DVSTimestampWrap = double(1 << 22) * 1000.0;
+
+/**
+ * Decodes one 4-byte Gen3 word, calling
+ * on_event(bool polarity, int x, int y, unsigned int timestamp)
+ * for each event in it.
+ */
+template <typename EventFn>
+inline void decode_gen3_word(const uint8_t* buf, DVSDecoderState& state, EventFn&& on_event)
+{
+    int grpAddr = 0;
+    int posY0 = 0;
+    int posY = 0;
+    bool pol = false;
+
+    //int packetID = 0;
+
+	int header = buf[0] & 0x7C;
+	//id = buf[0] & 0x03;
+
+	if (buf[0] & 0x80) {	// Group Packet
+
+		grpAddr = (buf[1] & 0xFC) >> 2;
+
+		if (buf[3]) {
+			posY0 = grpAddr << 3;
+			pol = (buf[1] & 0x01) ? true : false;
+			for (int n=0; n<8; n++) {
+				if ((buf[3] >> n) & 0x01) {
+					posY = posY0 + n;
+					if (posY < 480) on_event(pol, state.posX, 479-posY, state.timeStamp);
+				}
+			}
+		}
+
+		if (buf[2]) {
+			grpAddr += (header >> 2);	// Offset
+			posY0 = grpAddr << 3;
+			pol = (buf[1] & 0x02) ? true : false;
+			for (int n=0; n<8; n++) {
+				if ((buf[2] >> n) & 0x01) {
+					posY = posY0 + n;
+					if (posY < 480) on_event(pol, state.posX, 479-posY, state.timeStamp);
+				}
+			}
+		}
+
+	} else {					// Normal Packet
+
+		switch (header) {
+			case (0x04) :	// 0000 01** | --ST TTTT | TTTT T-CC | CCCC CCCC	Column Address (10) + SubTimestamp (10)
+				state.shortTs = ((buf[1] & 0x1F) << 5) | ((buf[2] & 0xF8) >> 3);
+				state.timeStamp = state.longTs + state.shortTs;
+				//posX = (((buf[2] & 0x03) << 8) | (buf[3] & 0xFF));		// Original
+				state.posX = 319 - (((buf[2] & 0x03) << 8) | (buf[3] & 0xFF));		// Rotation
+				break;
+
+			case (0x08) :	// 0000 01** | --TT TTTT | TTTT TTTT | TTTT TTTT	Reference Timestamp (22)
+				state.longTs = (((buf[1] & 0x3F) << 16) | ((buf[2] & 0xFF) << 8) | (buf[3] & 0xFF)) * 1000;
+				state.timeStamp = state.longTs + state.shortTs; // ?
+				break;
+
+			case (0x40) :	// 0100 00** | --II IIII | IIII IIII | IIII IIII	Packet ID (22)
+				// Packet ID is used to check packet loss
+				//packetID = ((buf[1] & 0x3F) << 26) | ((buf[2] & 0xFF) << 18) | ((buf[3] & 0xFF) << 10);
+				//std::cout << "packetid:" << packetID << std::endl;
+				break;
+
+			case (0x00) :	// 0000 0000 | 0000 0000 | 0000 0000 | 0000 0000	Padding
+				//i = dataLen;	// ignore all the remaining packet data
+				break;
+
+			default :		// This should not happen
+				break;
+		}
+	}
+}
+
+/**
+ * Decodes a buffer of 4-byte Gen3 words, which must start on a word
+ * boundary. A trailing partial word is ignored; use DVSDecoder to
+ * carry it into the next buffer.
+ */
+template <typename EventFn>
+inline void decode_gen3(const uint8_t* buf, int num_bytes, DVSDecoderState& state, EventFn&& on_event)
+{
+	int transferred = (num_bytes / 4) * 4;
+
+	for(int i=0; i<transferred; i+=4) {
+		decode_gen3_word(buf + i, state, on_event);
+	}
+}
+
+/**
+ * Advances the decoder state over a buffer of Gen3 words, exactly
+ * as decode_gen3 would, but without producing any events - only
+ * the timestamp and column words are looked at.
+ */
+inline void track_gen3_state(const uint8_t* buf, int num_bytes, DVSDecoderState& state)
+{
+    int transferred = (num_bytes / 4) * 4;
+
+	for(int i=0; i<transferred; i+=4) {
+		if (buf[i] & 0x80) {
+			continue;
+		}
+		switch (buf[i] & 0x7C) {
+			case (0x04) :
+				state.shortTs = ((buf[i+1] & 0x1F) << 5) | ((buf[i+2] & 0xF8) >> 3);
+				state.timeStamp = state.longTs + state.shortTs;
+				state.posX = 319 - (((buf[i + 2] & 0x03) << 8) | (buf[i + 3] & 0xFF));
+				break;
+			case (0x08) :
+				state.longTs = (((buf[i + 1] & 0x3F) << 16) | ((buf[i + 2] & 0xFF) << 8) | (buf[i + 3] & 0xFF)) * 1000;
+				state.timeStamp = state.longTs + state.shortTs;
+				break;
+			default :
+				break;
+		}
+	}
+}
+
+/**
+ * Does this look like a well-formed Gen3 word? Group packets can't
+ * be checked (any bit pattern is legal), but the other words have
+ * bits that must be zero, and column addresses must be on the sensor.
+ */
+inline bool is_valid_gen3_word(const uint8_t* w)
+{
+	if (w[0] & 0x80) {
+		return true;
+	}
+	switch (w[0] & 0x7C) {
+		case (0x04) :
+			return (w[1] & 0xC0) == 0 && (w[2] & 0x04) == 0 && (((w[2] & 0x03) << 8) | w[3]) < 320;
+		case (0x08) :
+		case (0x40) :
+			return (w[1] & 0xC0) == 0;
+		case (0x00) :
+			return w[0] == 0 && w[1] == 0 && w[2] == 0 && w[3] == 0;
+		default :
+			return false;
+	}
+}
+
+// A timestamp or column word: the ones that actually prove alignment.
+inline bool is_gen3_anchor_word(const uint8_t* w)
+{
+	int header = w[0] & 0x7C;
+	return !(w[0] & 0x80) && (header == 0x04 || header == 0x08) && is_valid_gen3_word(w);
+}
+
+/**
+ * What a DVSDecoder has seen. Every byte is counted at most once
+ * across invalid_words and bytes_discarded: the search for alignment
+ * starts after the invalid words that lost it, so the bytes it skips
+ * were never part of a counted word. Bytes dropped are therefore
+ * bytes_discarded + 4 * invalid_words.
+ */
+struct DVSDecoderStats {
+    unsigned long words = 0;            // words decoded
+    unsigned long invalid_words = 0;    // words that failed validation
+    unsigned long resyncs = 0;          // times alignment was re-established
+    unsigned long bytes_discarded = 0;  // bytes skipped while out of sync
+    unsigned long bytes_carried = 0;    // bytes held over to the next buffer
+};
+
+inline DVSDecoderStats& operator+=(DVSDecoderStats& a, const DVSDecoderStats& b)
+{
+    a.words += b.words;
+    a.invalid_words += b.invalid_words;
+    a.resyncs += b.resyncs;
+    a.bytes_discarded += b.bytes_discarded;
+    a.bytes_carried += b.bytes_carried;
+    return a;
+}
+
+/**
+ * A Gen3 decoder that treats its input as one continuous byte
+ * stream, however it happens to be split into buffers:
+ *
+ * - a partial word at the end of a buffer is carried over and
+ *   completed with the first bytes of the next one;
+ * - every word is validated. After max_invalid_words invalid words
+ *   in a row, the decoder declares itself out of sync and slides
+ *   one byte at a time until it finds resync_window valid words in
+ *   a row, at least one of them a timestamp or column word. Bytes
+ *   skipped while searching are dropped and counted. The search
+ *   looks across buffers too: out of sync, up to 4 * resync_window - 1
+ *   bytes are carried over instead of a partial word.
+ *
+ * This makes any transfer size safe, not just multiples of 4, and
+ * the decoder resyncs at the same byte whatever the buffer sizes.
+ */
+class DVSDecoder {
+public:
+    DVSDecoder(int max_invalid_words = 2, int resync_window = 8):
+        max_invalid_words(max_invalid_words),
+        resync_window(std::max(1, resync_window))
+    {
+        carry.reserve(4 * this->resync_window);
+    }
+
+    // Start over from the given state, dropping any carried bytes.
+    void reset(const DVSDecoderState& new_state = DVSDecoderState()) {
+        state = new_state;
+        carry.clear();
+        consecutive_invalid = 0;
+        synchronized = true;
+    }
+
+    template <typename EventFn>
+    void decode(const uint8_t* buf, int num_bytes, EventFn&& on_event);
+
+    // The bytes held over from the last buffer: a partial word, or
+    // out of sync, the bytes the search hasn't got past yet.
+    int get_num_carried() const { return carry.size(); }
+    const uint8_t* get_carried() const { return carry.data(); }
+
+    const DVSDecoderState& get_state() const { return state; }
+    const DVSDecoderStats& get_stats() const { return stats; }
+    bool is_synchronized() const { return synchronized; }
+
+protected:
+
+    template <typename EventFn>
+    void decode_word(const uint8_t* w, EventFn&& on_event) {
+        stats.words += 1;
+        if (is_valid_gen3_word(w)) {
+            consecutive_invalid = 0;
+            decode_gen3_word(w, state, on_event);
+        } else {
+            stats.invalid_words += 1;
+            consecutive_invalid += 1;
+            if (consecutive_invalid >= max_invalid_words) {
+                synchronized = false;
+            }
+        }
+    }
+
+    // Decodes or searches [p, end) as far as it can without more
+    // bytes, and returns where it had to stop.
+    template <typename EventFn>
+    const uint8_t* decode_until_short(const uint8_t* p, const uint8_t* end, EventFn&& on_event);
+
+    // Is there a run of valid words starting at p, within [p, end)?
+    bool aligned_at(const uint8_t* p, const uint8_t* end) const {
+        bool anchored = false;
+        int n = 0;
+        for (; n < resync_window && p + 4 <= end; n++, p += 4) {
+            if (!is_valid_gen3_word(p)) {
+                return false;
+            }
+            anchored = anchored || is_gen3_anchor_word(p);
+        }
+        return n == resync_window && anchored;
+    }
+
+    DVSDecoderState state;
+    DVSDecoderStats stats;
+
+    int max_invalid_words;
+    int resync_window;
+
+    std::vector<uint8_t> carry;
+    int consecutive_invalid = 0;
+    bool synchronized = true;
+};
+
+template <typename EventFn>
+const uint8_t* DVSDecoder::decode_until_short(const uint8_t* p, const uint8_t* end, EventFn&& on_event)
+{
+    while (p < end) {
+
+        if (!synchronized) {
+            if (end - p < 4 * resync_window) {
+                break;
+            }
+            if (aligned_at(p, end)) {
+                synchronized = true;
+                consecutive_invalid = 0;
+                stats.resyncs += 1;
+            } else {
+                p += 1;
+                stats.bytes_discarded += 1;
+            }
+            continue;
+        }
+
+        if (end - p < 4) {
+            break;
+        }
+
+        decode_word(p, on_event);
+        p += 4;
+    }
+    return p;
+}
+
+template <typename EventFn>
+void DVSDecoder::decode(const uint8_t* buf, int num_bytes, EventFn&& on_event)
+{
+    const uint8_t* p = buf;
+    const uint8_t* end = buf + num_bytes;
+
+    // Finish what the last buffer left off in the middle of: top the
+    // carried bytes up to what a search needs (a word is less), and
+    // go on from there, until the rest can be read from buf itself.
+    const size_t max_carry = 4 * resync_window;
+    while (!carry.empty() && p < end) {
+        size_t num_old = carry.size();
+        size_t num_new = std::min<size_t>(end - p, max_carry - num_old);
+        carry.insert(carry.end(), p, p + num_new);
+
+        size_t num_used = decode_until_short(carry.data(), carry.data() + carry.size(), on_event) - carry.data();
+        if (num_used >= num_old) {
+            p += num_used - num_old;
+            carry.clear();
+        } else {
+            p += num_new;
+            carry.erase(carry.begin(), carry.begin() + num_used);
+        }
+    }
+
+    if (carry.empty()) {
+        p = decode_until_short(p, end, on_event);
+        carry.assign(p, end);
+    }
+    stats.bytes_carried += carry.size();
+}
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_DECODER__H
@@ -1,13 +1,24 @@
 #ifndef ROBOFLEX_DVS__H
 #define ROBOFLEX_DVS__H
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
 #include <functional>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <cyusb.h>
 #include <Eigen/Dense>
 #include "roboflex_core/core.h"
 #include "roboflex_core/core_nodes/frequency_generator.h"
+#include "roboflex_dvs/pool.h"
+#include "roboflex_dvs/calibration.h"
+#include "roboflex_dvs/decoder.h"
+#include "roboflex_dvs/thread_tuning.h"
+#include "roboflex_dvs/tracing.h"
 
 namespace roboflex {
 namespace dvs {
@@ -25,25 +36,112 @@ public:
     inline static const char MessageName[] = "DVSRawData";
 
     DVSRawData(core::Message& other): core::Message(other) {}
-    DVSRawData(double t0, double t1, const uint8_t *byte_data, int num_bytes);
+    DVSRawData(double t0, double t1, const uint8_t *byte_data, int num_bytes, uint64_t transfer_id = 0);
 
     double get_t0() const { return root_val("t0").AsDouble(); }
     double get_t1() const { return root_val("t1").AsDouble(); }
+    uint64_t get_transfer_id() const { return root_val("transfer_id").AsUInt64(); }
     const uint8_t* get_data() const { return root_val("data").AsBlob().data(); }
     const int get_length() const { return root_val("data").AsBlob().size(); }
 
     void print_on(ostream& os) const override;
 };
 
+/**
+ * Raw dvs data (like DVSRawData), plus the state the decoder is in
+ * at its first word, so that it can be decoded on its own. This is
+ * what to send across transports: the raw words are about half the
+ * size of the equivalent DVSEigenData, and the sender doesn't decode.
+ *
+ * The receiving side decodes lazily: the first call to get_events()
+ * decodes the words (with a DVSDecoder, so invalid words are skipped
+ * and counted), and later calls return the cached result. The cache
+ * lives in the packet object, so consumers share it by getting their
+ * packet with from_message(): that's the packet itself, when the
+ * message is one (it was made in this process), and a new one only
+ * when it's a plain message (it came over a transport). DVSEncoder
+ * does this, so it takes these as well as DVSRawData.
+ */
+class DVSRawPacket: public core::Message {
+public:
+    // One row per event: timestamp, x, y, polarity.
+    typedef Eigen::Matrix<unsigned int, Eigen::Dynamic, 4, Eigen::RowMajor> DVSEventList;
+
+    inline static const char MessageName[] = "DVSRawPacket";
+
+    DVSRawPacket(core::Message& other): core::Message(other) {}
+    DVSRawPacket(double t0, double t1, const uint8_t *byte_data, int num_bytes, const DVSDecoderState& state, uint64_t transfer_id = 0);
+
+    static std::shared_ptr<DVSRawPacket> from_message(core::MessagePtr m);
+
+    double get_t0() const { return root_val("t0").AsDouble(); }
+    double get_t1() const { return root_val("t1").AsDouble(); }
+    uint64_t get_transfer_id() const { return root_val("transfer_id").AsUInt64(); }
+    const uint8_t* get_data() const { return root_val("data").AsBlob().data(); }
+    int get_length() const { return root_val("data").AsBlob().size(); }
+
+    DVSDecoderState get_decoder_state() const;
+
+    const DVSEventList& get_events() const;
+    const DVSDecoderStats& get_decoder_stats() const;
+    bool is_decoded() const { return decoded; }
+
+    void print_on(ostream& os) const override;
+
+protected:
+    mutable std::once_flag decode_once;
+    mutable DVSEventList events;
+    mutable DVSDecoderStats decoder_stats;
+    mutable std::atomic<bool> decoded{false};
+};
+
+/**
+ * What a DVSEigenData batch covers, readable without touching the
+ * events themselves: the first and last device timestamps (usec),
+ * the USB transfer the first event came in and the host time at
+ * which that transfer had been read (0 if unknown), and how much the
+ * encoder had dropped by the time it built the batch - events that
+ * the undistortion filtered out, and bytes the decoder couldn't use
+ * (skipped while out of sync, or in invalid words; see
+ * DVSDecoderStats). The drop counters are cumulative since the
+ * encoder started; past a DVSRateController, dropped_events also
+ * counts the events it dropped.
+ */
+struct DVSBatchMetadata {
+    unsigned int t_first = 0;
+    unsigned int t_last = 0;
+    uint64_t transfer_id = 0;
+    double transfer_t1 = 0;
+    unsigned long dropped_events = 0;
+    unsigned long dropped_bytes = 0;
+};
+
 /**
  * The datatype containing parsed dvs event data: two frames
  * (on events and off events) in two eigen matrices, where
  * each row corresponds to one event, the first column is x,
  * and the second column is y.
+ *
+ * When the encoder undistorts with subpixel output, the message
+ * also carries the unrounded coordinates of the same events, in
+ * two float frames of the same shape.
+ *
+ * Every raw message carries the sequence number of the USB transfer
+ * it came from (counting from 1 since the sensor started), and frames
+ * carry it on, so trace spans can be tied to one batch (see tracing.h).
+ *
+ * The per-polarity event counts and the rest of DVSBatchMetadata are
+ * stored as plain values, so schedulers can batch or skip without
+ * deserializing the frames. Optionally, the events are also stored
+ * in arrival order, on and off interleaved, as (x, y, polarity, t)
+ * rows: a frame can span several timestamps (see DVSEncoder), and
+ * this is where each event's own is kept.
  */
 class DVSEigenData: public core::Message {
 public:
     typedef Eigen::Matrix<unsigned short, Eigen::Dynamic, 2> DVSFrame;
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 2> DVSSubpixelFrame;
+    typedef Eigen::Matrix<unsigned int, Eigen::Dynamic, 4> DVSInterleavedFrame;
 
     inline static const char MessageName[] = "DVSEigenData";
 
@@ -51,12 +149,23 @@ public:
     DVSEigenData(
         unsigned short *on_event_data, int num_on_events,
         unsigned short *off_event_data, int num_off_events,
-        double t, double t0, double t1);
+        double t, double t0, double t1,
+        const DVSBatchMetadata& metadata = DVSBatchMetadata(),
+        const float *on_subpixel_data = nullptr,
+        const float *off_subpixel_data = nullptr,
+        const unsigned int *interleaved_data = nullptr);
 
     double get_t() const { return root_val("t").AsDouble(); }
     double get_t0() const { return root_val("t0").AsDouble(); }
     double get_t1() const { return root_val("t1").AsDouble(); }
 
+    // The USB transfer that the first event of this frame came in.
+    uint64_t get_transfer_id() const { return root_val("transfer_id").AsUInt64(); }
+
+    DVSBatchMetadata get_metadata() const;
+    int get_num_on_events() const;
+    int get_num_off_events() const;
+
     const DVSFrame get_on_events() const {
         return serialization::deserialize_eigen_matrix<unsigned short, Eigen::Dynamic, 2>(root_val("on_events"));
     }
@@ -65,6 +174,23 @@ public:
         return serialization::deserialize_eigen_matrix<unsigned short, Eigen::Dynamic, 2>(root_val("off_events"));
     }
 
+    bool has_subpixel() const { return !root_val("on_subpixel").IsNull(); }
+
+    const DVSSubpixelFrame get_on_subpixel() const {
+        return serialization::deserialize_eigen_matrix<float, Eigen::Dynamic, 2>(root_val("on_subpixel"));
+    }
+
+    const DVSSubpixelFrame get_off_subpixel() const {
+        return serialization::deserialize_eigen_matrix<float, Eigen::Dynamic, 2>(root_val("off_subpixel"));
+    }
+
+    bool has_interleaved() const { return !root_val("events").IsNull(); }
+
+    // All the events in arrival order, one row per event: x, y, polarity, t.
+    const DVSInterleavedFrame get_interleaved_events() const {
+        return serialization::deserialize_eigen_matrix<unsigned int, Eigen::Dynamic, 4>(root_val("events"));
+    }
+
     void print_on(ostream& os) const override;
 };
 
@@ -85,29 +211,133 @@ public:
 };
 
 
+/**
+ * Something whose I2C registers can be read and written, like the
+ * sensor's bias registers (slave address 0x20). Values are one byte
+ * for the DVS and FX3 slaves, two for the others. Returns -1 (read)
+ * or false (write) on failure.
+ */
+class DVSRegisterInterface {
+public:
+    virtual ~DVSRegisterInterface() {}
+    virtual int read_register(int slave_address, int address) = 0;
+    virtual bool write_register(int slave_address, int address, int value) = 0;
+};
+
 /**
  * This dvs sensor pushes the raw data it reads from the dvs
  * device, with no parsing or interpretation - that's left
  * to other nodes (the DVSEncoder node, to be precise).
  *
+ * The DVSRawData message objects (not their payloads, which
+ * roboflex_core's builder allocates) are recycled through a bounded
+ * pool, rather than allocated for each transfer.
+ *
+ * Each bulk transfer reads up to transfer_size bytes. Any positive
+ * size works, including ones that aren't a multiple of the 4-byte
+ * word size: the DVSEncoder's decoder carries partial words, and
+ * while it's out of sync, its search for alignment, over to the next
+ * transfer.
+ *
+ * The read loop can be pinned to cores, run under SCHED_FIFO or
+ * SCHED_RR, and lock the whole process's memory as mapped when it
+ * starts (see DVSThreadOptions: that's process-wide); the
+ * jitter histogram, of intervals between completed transfers, shows
+ * what each setting buys.
+ *
+ * With tracing enabled, each transfer is recorded as a "transfer" span.
+ *
+ * Registers can be read and written while streaming, through USB
+ * control transfers (the same ones dvsconf uses to load scripts).
+ *
  * expects: nothing
  * signals: DVSRawData
  */
-class DVSSensor: public core::RunnableNode {
+class DVSSensor: public core::RunnableNode, public DVSRegisterInterface {
 public:
-    DVSSensor(const std::string& name = "DVSSensor");
+    DVSSensor(
+        const std::string& name = "DVSSensor",
+        int transfer_size = 1024,
+        const DVSThreadOptions& thread_options = DVSThreadOptions());
     virtual ~DVSSensor();
+
+    int get_transfer_size() const { return transfer_size; }
+    const DVSThreadOptions& get_thread_options() const { return thread_options; }
+
+    // Intervals between consecutive completed transfers.
+    const JitterHistogram& get_jitter_histogram() const { return jitter_histogram; }
+    void reset_jitter_histogram() { jitter_histogram.reset(); }
+
+    BlockPoolStats get_pool_stats() const { return raw_data_pool.get_stats(); }
+
+    int read_register(int slave_address, int address) override;
+    bool write_register(int slave_address, int address, int value) override;
+
 protected:
     void child_thread_fn() override;
     libusb_device_handle* dvs_handle_;
+    int transfer_size;
+    DVSThreadOptions thread_options;
+    JitterHistogram jitter_histogram;
+    uint64_t num_transfers = 0;
+    MessagePool<DVSRawData> raw_data_pool;
 };
 
 
 /**
- * Parses raw dvs data into "frames" (yeah, that means it's not
- * actually event-based).
+ * Wraps DVSRawData into self-contained DVSRawPacket messages, for
+ * shipping raw data to another host. Only the timestamp and column
+ * words are looked at, to keep track of the decoder state. Packets
+ * always hold whole words; a partial word at the end of a transfer
+ * goes out with the next packet.
  *
  * expects: DVSRawData
+ * signals: DVSRawPacket
+ */
+class DVSRawPacketizer: public core::Node {
+public:
+    DVSRawPacketizer(const std::string &name = "DVSRawPacketizer");
+
+    void receive(core::MessagePtr m) override;
+
+protected:
+    DVSDecoderState decoder_state;
+    std::vector<uint8_t> aligned_bytes;
+    MessagePool<DVSRawPacket> raw_packet_pool;
+};
+
+
+/**
+ * Parses raw dvs data into "frames" (yeah, that means it's not
+ * actually event-based). The DVSEigenData message objects (not
+ * their payloads) are recycled through a bounded pool.
+ *
+ * The decoder treats DVSRawData as one continuous stream: partial
+ * words are carried across messages, and words are validated so it
+ * can resynchronize after corruption (see DVSDecoder).
+ *
+ * DVSRawPacket works as input too: its events are taken from the
+ * packet's own (shared) cache, which decodes from the state the
+ * packet carries.
+ *
+ * Optionally, every event is undistorted (and rectified) through a
+ * DVSUndistortionTable as it is decoded, so that downstream nodes
+ * don't each have to. Events that map off the sensor are dropped.
+ * With subpixel set, the unrounded coordinates are emitted too.
+ *
+ * With tracing enabled, records "decode" spans per input message and
+ * "build" spans per output frame.
+ *
+ * A frame holds the events of one sensor timestamp, unless a batch
+ * duration is set: then it collects consecutive timestamps until the
+ * next one is at least batch_duration usec after its first, or goes
+ * backwards from the one before. Timestamps only increase within a
+ * frame, so its t is its last and latest timestamp, and its
+ * DVSBatchMetadata has the first and last. With interleaved set,
+ * frames also carry the events in arrival order, each with its own
+ * timestamp (see DVSEigenData).
+ *
+ * expects: DVSRawData or DVSRawPacket
  * signals: DVSEigenData
  */
 class DVSEncoder: public core::Node {
@@ -116,35 +346,178 @@ public:
 
     void receive(core::MessagePtr m) override;
 
+    BlockPoolStats get_pool_stats() const { return eigen_data_pool.get_stats(); }
+
+    // Set this before data starts flowing; pass nullptr to turn it off.
+    void set_undistortion(std::shared_ptr<const DVSUndistortionTable> table, bool subpixel = false);
+    unsigned long get_num_undistortion_dropped() const { return num_undistortion_dropped; }
+
+    // Set this before data starts flowing.
+    void set_interleaved(bool interleaved);
+    bool is_interleaved() const { return interleaved; }
+
+    // Set this before data starts flowing; 0 means one timestamp per frame.
+    void set_batch_duration(unsigned int usec) { batch_duration = usec; }
+    unsigned int get_batch_duration() const { return batch_duration; }
+
+    DVSDecoderStats get_decoder_stats() const;
+
 protected:
     void got_event(bool on_off, int x, int y, unsigned int t);
 
+    MessagePool<DVSEigenData> eigen_data_pool;
+
+    std::shared_ptr<const DVSUndistortionTable> undistortion;
+    bool subpixel = false;
+    std::vector<float> current_on_subpixel;
+    std::vector<float> current_off_subpixel;
+    unsigned long num_undistortion_dropped = 0;
+
+    bool interleaved = false;
+    std::vector<unsigned int> current_interleaved;
+
+    unsigned int batch_duration = 0;
+
     double t0;
     unsigned int prev_time_stamp;
+    unsigned int frame_t_first = 0;
+
+    uint64_t decoding_transfer_id = 0;
+    uint64_t frame_transfer_id = 0;
+    double decoding_transfer_t1 = 0;
+    double frame_transfer_t1 = 0;
 
     unsigned int current_on_event_index;
     unsigned int current_off_event_index;
     unsigned short current_on_events[640*480*2];
     unsigned short current_off_events[640*480*2];
 
-	unsigned int longTs = 0; // * 10 usec
-	unsigned int shortTs = 0; // * 1 msec
-	unsigned int timeStamp = 0; // * usec
+    DVSDecoder decoder;
+    DVSDecoderStats packet_decoder_stats;
 };
 
-class DVSEigenToGrayScale: public nodes::FrequencyGenerator {
+/**
+ * Base for the DVS nodes that emit periodically.
+ *
+ * By default, emission is driven by the wall clock, through
+ * nodes::FrequencyGenerator: start() the node and emit() is called
+ * at emit_frequency_hz. With event_period > 0, emission is driven
+ * by sensor timestamps instead: subclasses call advance_event_time(t)
+ * before taking in a batch stamped t, and emit() runs synchronously,
+ * in the receiving thread, whenever event time crosses a multiple of
+ * event_period (in sensor timestamp units, microseconds). Offline
+ * replays are then deterministic and only limited by the CPU, and
+ * the node doesn't need to be started at all.
+ *
+ * A gap in the stream longer than one period produces a single emit,
+ * and a timestamp that jumps backwards re-anchors the schedule.
+ */
+class DVSPeriodicNode: public nodes::FrequencyGenerator {
 public:
+    DVSPeriodicNode(
+        float emit_frequency_hz,
+        double event_period,
+        const std::string &name);
+
+    bool is_event_time_driven() const { return event_period > 0; }
+    double get_event_period() const { return event_period; }
+
+protected:
+
+    void on_trigger(double wall_clock_time) override;
+    void advance_event_time(double t);
+
+    // The time is wall clock time or event time, depending on the mode.
+    virtual void emit(double time) = 0;
+
+    double event_period;
+    double next_emit_t = -1;
+};
+
+/**
+ * How DVSEigenToGrayScale maps its signed event counts to 8 bits.
+ *
+ * Fixed: 128 + event_weight * count, clamped to [0, 255].
+ * MinMax: the smallest count maps to 0, the largest to 255.
+ * AbsMax: symmetric around 128, scaled by the largest |count|.
+ */
+enum class GrayScaleNormalization {
+    Fixed,
+    MinMax,
+    AbsMax
+};
+
+/**
+ * Accumulates events into a signed 16-bit count image (+1 per on
+ * event, -1 per off event, saturating), and periodically emits it
+ * as an 8-bit grayscale image, normalized at emit time.
+ *
+ * Batches of at least parallel_threshold events are split across
+ * num_threads threads, each scattering into its own partial count
+ * image; then each thread reduces one band of rows of the partials
+ * into the count image, saturating, and zeroes that band for the next
+ * batch. The threads and partials are kept for the node's lifetime;
+ * the threads are started by the first batch that needs them.
+ *
+ * Emission follows the wall clock, or event time if event_period is
+ * set (see DVSPeriodicNode).
+ *
+ * With tracing enabled, records "accumulate" spans per batch and
+ * "emit" spans, the latter tagged with the last transfer accumulated.
+ *
+ * expects: DVSEigenData
+ * signals: EigenMessage "DVSImage", under the key "image"
+ */
+class DVSEigenToGrayScale: public DVSPeriodicNode {
+public:
+    typedef Eigen::Matrix<int16_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> CountImage;
+    typedef Eigen::Matrix<int32_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> PartialCountImage;
+
     DVSEigenToGrayScale(
         float emit_frequency_hz = 24.0,
-        const std::string &name = "DVSEigenToGrayScale");
+        const std::string &name = "DVSEigenToGrayScale",
+        GrayScaleNormalization normalization = GrayScaleNormalization::Fixed,
+        int event_weight = 40,
+        int parallel_threshold = 65536,
+        int num_threads = 4,
+        double event_period = 0);
+
+    virtual ~DVSEigenToGrayScale();
 
     void receive(core::MessagePtr m) override;
 
+    GrayScaleNormalization get_normalization() const { return normalization; }
+    int get_event_weight() const { return event_weight; }
+
 protected:
 
-    void on_trigger(double wall_clock_time) override;
+    void emit(double time) override;
+
+    void accumulate(const DVSEigenData::DVSFrame& on_events, const DVSEigenData::DVSFrame& off_events);
+    void accumulate_parallel(const DVSEigenData::DVSFrame& on_events, const DVSEigenData::DVSFrame& off_events);
+    void run_on_workers(const std::function<void(int)>& job);
+    void worker_thread_fn(int k);
+    void normalize_into_image();
+
+    GrayScaleNormalization normalization;
+    int event_weight;
+    int parallel_threshold;
+    int num_threads;
 
     std::mutex image_mutex;
+    CountImage count_image;
+    uint64_t last_transfer_id = 0;
+    std::vector<PartialCountImage> partial_counts;
+
+    std::vector<std::thread> workers;
+    std::mutex workers_mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    std::function<void(int)> work_job;
+    uint64_t work_generation = 0;
+    int workers_busy = 0;
+    bool workers_stopping = false;
+
     //xt::xtensor<uint8_t, 2> accumulated_image;
     Eigen::Matrix<uint8_t, 320, 480, Eigen::RowMajor> accumulated_image;
 };
@@ -0,0 +1,145 @@
+#ifndef ROBOFLEX_DVS_EVENT_LOG__H
+#define ROBOFLEX_DVS_EVENT_LOG__H
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * The event log file format:
+ *
+ *   header:  "RFDVSLOG" | uint32 version | uint32 reserved
+ *   blocks:  one after the other, each a sequence of frames:
+ *              double t | double t0 | double t1 |
+ *              uint32 num_on | uint32 num_off |
+ *              num_on (x, y) uint16 pairs | num_off (x, y) uint16 pairs
+ *   index:   one DVSEventLogBlock per block
+ *   footer:  uint64 index offset | uint64 num blocks | "RFDVSIDX"
+ *
+ * Values are stored in host byte order (little-endian on every
+ * platform we run on). The index records the time range
+ * and the bounding box of every block, so that a query can find the
+ * first relevant block with a binary search and decode only blocks
+ * that overlap it.
+ *
+ * The frame time t is log time, not raw sensor time: sensor time
+ * wraps around about every 70 minutes (see DVSTimestampWrap) and
+ * starts over when the device restarts, so the writer unwraps it
+ * into a time that never decreases, in usec. That keeps blocks sorted
+ * by time over recordings of any length, which the binary search
+ * needs; a log whose index isn't sorted is rejected when it's opened.
+ */
+struct DVSEventLogBlock {
+    double t_begin = 0;
+    double t_end = 0;
+    uint64_t offset = 0;
+    uint64_t num_bytes = 0;
+    uint64_t num_events = 0;
+    uint16_t x_min = 0xFFFF;
+    uint16_t y_min = 0xFFFF;
+    uint16_t x_max = 0;
+    uint16_t y_max = 0;
+    uint32_t num_frames = 0;
+    uint32_t reserved = 0;
+};
+
+/**
+ * Writes incoming DVSEigenData to an event log file, in blocks of
+ * about events_per_block events. The index is written by close(),
+ * which the destructor calls if you didn't.
+ *
+ * A failed write (a full disk, say) throws, from receive() or close(),
+ * and closes the file: a log that can't be finished can't be read.
+ * The destructor reports it on stderr instead.
+ *
+ * Sensor time is unwrapped into log time: when it goes backwards by
+ * what the host clock (t0) says is a wrap, log time carries on past
+ * it. Any other backwards jump (a device restart, or a stream that
+ * got out of order) is a discontinuity: log time carries on from
+ * where it was, advanced by the host clock, and the jump is counted.
+ *
+ * expects: DVSEigenData
+ * signals: nothing
+ */
+class DVSEventLogWriter: public core::Node {
+public:
+    DVSEventLogWriter(
+        const std::string& filename,
+        unsigned int events_per_block = 65536,
+        const std::string& name = "DVSEventLogWriter");
+    virtual ~DVSEventLogWriter();
+
+    void receive(core::MessagePtr m) override;
+
+    void close();
+
+    size_t get_num_blocks() const { return index.size(); }
+    unsigned long get_num_wraps() const { return num_wraps; }
+    unsigned long get_num_discontinuities() const { return num_discontinuities; }
+
+protected:
+    void flush_block();
+    void check_written();
+    double unwrap(double t, double t0);
+
+    std::string filename;
+    unsigned int events_per_block;
+
+    std::mutex file_mutex;
+    std::ofstream file;
+    std::vector<char> block_bytes;
+    DVSEventLogBlock current_block;
+    std::vector<DVSEventLogBlock> index;
+
+    double last_sensor_t = -1;
+    double last_t0 = 0;
+    double last_log_t = 0;
+    double time_offset = 0;
+    unsigned long num_wraps = 0;
+    unsigned long num_discontinuities = 0;
+};
+
+/**
+ * Reads an event log, and answers spatio-temporal slice queries:
+ * "all events with t_begin <= t <= t_end and x_min <= x <= x_max
+ * and y_min <= y <= y_max". The result comes back as DVSEigenData,
+ * one per sensor timestamp, like DVSEncoder produces them, except
+ * that t is log time (which is what the query is in, too).
+ *
+ * The index is checked against the file when it's opened, and every
+ * frame against its block when it's read; a corrupt or truncated log
+ * throws rather than reading past either.
+ */
+class DVSEventLog {
+public:
+    DVSEventLog(const std::string& filename);
+
+    std::vector<std::shared_ptr<DVSEigenData>> query(
+        double t_begin,
+        double t_end,
+        int x_min = 0,
+        int y_min = 0,
+        int x_max = 319,
+        int y_max = 479);
+
+    const std::vector<DVSEventLogBlock>& get_index() const { return index; }
+    double get_t_begin() const;
+    double get_t_end() const;
+
+protected:
+    std::string filename;
+    std::ifstream file;
+    std::vector<DVSEventLogBlock> index;
+    std::vector<char> block_bytes;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_EVENT_LOG__H
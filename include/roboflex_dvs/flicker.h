@@ -0,0 +1,117 @@
+#ifndef ROBOFLEX_DVS_FLICKER__H
+#define ROBOFLEX_DVS_FLICKER__H
+
+#include <mutex>
+#include <vector>
+#include <Eigen/Dense>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * Blinking markers found by the DVSFlickerDetector: one row per
+ * marker, with the columns
+ *
+ *   id, x, y, frequency, num_pixels
+ *
+ * id is the index of the matching configured marker frequency, or
+ * -1 if no marker frequencies were configured. Positions are in
+ * pixels, frequencies in Hz. t is the time of the emit: event time
+ * or wall clock time, depending on how the node is driven.
+ */
+class DVSFlickerMarkers: public core::Message {
+public:
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 5, Eigen::RowMajor> Markers;
+
+    inline static const char MessageName[] = "DVSFlickerMarkers";
+
+    DVSFlickerMarkers(core::Message& other): core::Message(other) {}
+    DVSFlickerMarkers(const Markers& markers, double t);
+
+    double get_t() const { return root_val("t").AsDouble(); }
+
+    const Markers get_markers() const {
+        return serialization::deserialize_eigen_matrix<float, Eigen::Dynamic, 5, Eigen::RowMajor>(root_val("markers"));
+    }
+
+    void print_on(ostream& os) const override;
+};
+
+/**
+ * Finds blinking markers (LEDs) by the frequency they flicker at.
+ *
+ * Every pixel estimates its own blink period from the intervals
+ * between its transitions of the same polarity, using just a few
+ * per-pixel arrays (last on and off times, a smoothed period, and a
+ * stability count), so each event costs O(1) and touches one or two
+ * cache lines. Events closer together than the shortest period are
+ * taken to be the same transition. Pixels whose period has been
+ * consistent for min_stability intervals become candidates.
+ *
+ * On emit, candidates are matched to the configured marker
+ * frequencies (within frequency_tolerance, relative), or if there are
+ * none, grouped by frequency in bins of that relative width. Each
+ * group is clustered spatially, over a grid of cell_size pixels, and
+ * clusters of at least min_pixels pixels are reported as markers.
+ *
+ * When sensor time jumps backwards (it wraps, and starts over when
+ * the sensor restarts), every pixel's estimate is dropped, and the
+ * markers come back once they've blinked min_stability times again.
+ *
+ * expects: DVSEigenData
+ * signals: DVSFlickerMarkers
+ */
+class DVSFlickerDetector: public DVSPeriodicNode {
+public:
+    DVSFlickerDetector(
+        float emit_frequency_hz = 30.0,
+        const std::vector<double>& marker_frequencies = {},
+        double min_frequency = 50.0,
+        double max_frequency = 5000.0,
+        double frequency_tolerance = 0.1,
+        int min_stability = 3,
+        int cell_size = 8,
+        int min_pixels = 3,
+        double event_period = 0,
+        const std::string &name = "DVSFlickerDetector");
+
+    void receive(core::MessagePtr m) override;
+
+    const std::vector<double>& get_marker_frequencies() const { return marker_frequencies; }
+    size_t get_num_candidates() const { return candidates.size(); }
+
+protected:
+
+    void emit(double time) override;
+
+    void process_events(const DVSEigenData::DVSFrame& events, bool on_off, uint32_t t);
+    void reset_pixels();
+    int frequency_group(double frequency) const;
+
+    std::vector<double> marker_frequencies;
+    float min_period;
+    float max_period;
+    double frequency_tolerance;
+    int min_stability;
+    int cell_size;
+    int min_pixels;
+
+    std::mutex state_mutex;
+    uint32_t newest_t = 0;
+
+    // Per-pixel state, indexed by x*480 + y.
+    std::vector<uint32_t> last_on_t;
+    std::vector<uint32_t> last_off_t;
+    std::vector<float> period;
+    std::vector<uint8_t> stability;
+    std::vector<uint8_t> is_candidate;
+
+    std::vector<uint32_t> candidates;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_FLICKER__H
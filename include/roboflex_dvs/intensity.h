@@ -0,0 +1,75 @@
+#ifndef ROBOFLEX_DVS_INTENSITY__H
+#define ROBOFLEX_DVS_INTENSITY__H
+
+#include <mutex>
+#include <Eigen/Dense>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * Keeps a per-pixel estimate of log intensity, and periodically
+ * emits it as an 8-bit grayscale image.
+ *
+ * Each event adds +contrast_threshold (on) or -contrast_threshold
+ * (off) to its pixel. A leaky (high-pass) filter pulls every pixel
+ * back toward zero at decay_rate per second, so the estimate doesn't
+ * drift, but static structure survives until it leaks away - unlike
+ * DVSEigenToGrayScale, which starts from scratch every frame.
+ *
+ * Decay is applied lazily: each pixel remembers when it was last
+ * updated, the decay since then is applied when an event touches it,
+ * and the whole image is decayed to the current event time in one
+ * vectorized pass only when it is emitted. Timestamps are sensor
+ * time, in microseconds. When sensor time jumps backwards (it wraps,
+ * and starts over when the sensor restarts), the image is decayed up
+ * to the old time, and then decay carries on from the new one.
+ *
+ * Like the other periodic DVS nodes, emission can be driven by event
+ * time instead of the wall clock (see DVSPeriodicNode).
+ *
+ * expects: DVSEigenData
+ * signals: EigenMessage "DVSImage", under the key "image"
+ */
+class DVSIntensityReconstructor: public DVSPeriodicNode {
+public:
+    typedef Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> LogIntensity;
+    typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Timestamps;
+
+    DVSIntensityReconstructor(
+        float emit_frequency_hz = 24.0,
+        float contrast_threshold = 0.1,
+        float decay_rate = 2.0,
+        float display_gain = 127.0,
+        double event_period = 0,
+        const std::string &name = "DVSIntensityReconstructor");
+
+    void receive(core::MessagePtr m) override;
+
+    // The current estimate, decayed to the latest event time.
+    LogIntensity get_log_intensity();
+
+protected:
+
+    void emit(double time) override;
+
+    void decay_to_latest();
+
+    float contrast_threshold;
+    float decay_rate;
+    float display_gain;
+
+    std::mutex state_mutex;
+    LogIntensity log_intensity;
+    Timestamps last_update;
+    double latest_t = 0;
+
+    Eigen::Matrix<uint8_t, 320, 480, Eigen::RowMajor> image;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_INTENSITY__H
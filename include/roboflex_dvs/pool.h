@@ -0,0 +1,110 @@
+#ifndef ROBOFLEX_DVS_POOL__H
+#define ROBOFLEX_DVS_POOL__H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace roboflex {
+namespace dvs {
+
+struct BlockPoolStats {
+    unsigned long hits = 0;      // allocations served from the free list
+    unsigned long misses = 0;    // allocations that went to the heap
+    unsigned long recycled = 0;  // deallocations kept on the free list
+    unsigned long released = 0;  // deallocations returned to the heap (pool full)
+    size_t block_size = 0;
+    size_t free_blocks = 0;
+    size_t max_free_blocks = 0;
+};
+
+/**
+ * A bounded, thread-safe free list of equally sized memory blocks.
+ * The size of the first allocation fixes the block size; requests of
+ * any other size pass straight through to the heap (and count as
+ * misses). At most max_free_blocks blocks are ever held idle, so the
+ * memory the pool keeps around is bounded.
+ */
+class BlockPool {
+public:
+    BlockPool(size_t max_free_blocks = 4096);
+    ~BlockPool();
+
+    void* allocate(size_t num_bytes);
+    void deallocate(void* p, size_t num_bytes);
+
+    BlockPoolStats get_stats() const;
+
+protected:
+    mutable std::mutex pool_mutex;
+    std::vector<void*> free_blocks;
+    size_t max_free_blocks;
+    BlockPoolStats stats;
+};
+
+/**
+ * Standard allocator over a shared BlockPool. Meant for
+ * std::allocate_shared, so that a message and its control block
+ * come out of one recycled block. Every copy (and rebind) shares
+ * the pool, which stays alive until the last message allocated
+ * from it is gone.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator(std::shared_ptr<BlockPool> pool): pool(pool) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other): pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(pool->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        pool->deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const { return pool == other.pool; }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const { return pool != other.pool; }
+
+    std::shared_ptr<BlockPool> pool;
+};
+
+/**
+ * Makes shared messages of type T out of a BlockPool, instead of
+ * with make_shared.
+ *
+ * Only the message object and its control block are pooled: that's
+ * one of the two heap allocations per message. The other, the
+ * serialized payload, is made by the flexbuffers builder that
+ * core::Message hands out, and the message owns it, so it's still a
+ * fresh allocation every time. examples/pool_benchmark.cpp measures
+ * what the pool saves, for DVSEigenData of a given size.
+ */
+template <typename T>
+class MessagePool {
+public:
+    MessagePool(size_t max_free_blocks = 4096):
+        pool(std::make_shared<BlockPool>(max_free_blocks)) {}
+
+    template <typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(PoolAllocator<T>(pool), std::forward<Args>(args)...);
+    }
+
+    BlockPoolStats get_stats() const { return pool->get_stats(); }
+
+protected:
+    std::shared_ptr<BlockPool> pool;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_POOL__H
@@ -0,0 +1,77 @@
+#ifndef ROBOFLEX_DVS_PYRAMID__H
+#define ROBOFLEX_DVS_PYRAMID__H
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <Eigen/Dense>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+constexpr int NumPyramidLevels = 4;
+
+/**
+ * Event-count images at several resolutions: level l is the sensor
+ * image downsampled by 2^l (320x480, 160x240, 80x120, 40x60), under
+ * the keys "level0" ... "level3". Only the levels in level_mask
+ * (bit l for level l) are present. t is the time of the emit: event
+ * time or wall clock time, depending on how the node is driven.
+ */
+class DVSEventPyramidData: public core::Message {
+public:
+    typedef Eigen::Matrix<uint16_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> CountImage;
+
+    inline static const char MessageName[] = "DVSEventPyramidData";
+
+    DVSEventPyramidData(core::Message& other): core::Message(other) {}
+    DVSEventPyramidData(const std::array<CountImage, NumPyramidLevels>& levels, int level_mask, double t);
+
+    double get_t() const { return root_val("t").AsDouble(); }
+    int get_level_mask() const { return root_val("level_mask").AsInt32(); }
+    bool has_level(int level) const { return (get_level_mask() >> level) & 1; }
+
+    const CountImage get_level(int level) const;
+
+    void print_on(ostream& os) const override;
+};
+
+/**
+ * Maintains event-count images at 1x, 1/2, 1/4 and 1/8 resolution.
+ * Each event increments its (saturating, 16-bit) cell at every level
+ * directly, so there's never a downsampling pass over the full image.
+ * Only the levels in level_mask are maintained. On emit, they are
+ * published and their counts start over.
+ *
+ * expects: DVSEigenData
+ * signals: DVSEventPyramidData
+ */
+class DVSEventPyramid: public DVSPeriodicNode {
+public:
+    DVSEventPyramid(
+        float emit_frequency_hz = 24.0,
+        int level_mask = 0xF,
+        double event_period = 0,
+        const std::string &name = "DVSEventPyramid");
+
+    void receive(core::MessagePtr m) override;
+
+    int get_level_mask() const { return level_mask; }
+
+protected:
+
+    void emit(double time) override;
+
+    int level_mask;
+    std::vector<int> active_levels;
+
+    std::mutex counts_mutex;
+    std::array<DVSEventPyramidData::CountImage, NumPyramidLevels> counts;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_PYRAMID__H
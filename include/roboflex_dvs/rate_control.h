@@ -0,0 +1,120 @@
+#ifndef ROBOFLEX_DVS_RATE_CONTROL__H
+#define ROBOFLEX_DVS_RATE_CONTROL__H
+
+#include <mutex>
+#include <vector>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+#include "roboflex_dvs/pool.h"
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * How the DVSRateController sheds load once it's behind.
+ *
+ * RandomDecimation: keep each event with probability keep_fraction.
+ * SpatialSubsampling: keep only events on a pixel grid whose stride
+ *     grows as keep_fraction shrinks.
+ * DropPolarity: drop all off events.
+ * DropOldest: drop whole batches that are older than max_lag.
+ */
+enum class DegradationPolicy {
+    RandomDecimation,
+    SpatialSubsampling,
+    DropPolarity,
+    DropOldest
+};
+
+struct DVSRateControllerMetrics {
+    unsigned long batches_in = 0;
+    unsigned long batches_out = 0;
+    unsigned long batches_dropped = 0;
+    unsigned long events_in = 0;
+    unsigned long events_out = 0;
+    unsigned long events_dropped = 0;
+
+    // Current state of the controller.
+    double keep_fraction = 1.0;
+    double lag = 0.0;
+    double utilization = 0.0;
+    bool degrading = false;
+};
+
+/**
+ * Sits between the DVSEncoder and its consumers, and degrades the
+ * event stream in a controlled way when the consumers can't keep up.
+ *
+ * Two signals are watched: the lag of each batch (host time now,
+ * minus the host time at which the USB transfer its first event came
+ * in had been read, from its DVSBatchMetadata), which is how long the
+ * batch has waited behind the ones before it; and
+ * the utilization of the downstream chain (smoothed time spent
+ * inside signal(), over the smoothed time between batches). When
+ * either crosses its limit, the keep fraction is halved, at most
+ * once per control_period seconds; once both are back under their
+ * limits, it recovers additively. The selected policy decides what
+ * a keep fraction below 1 actually drops. Every dropped event and
+ * batch is counted in the metrics.
+ *
+ * Thinned batches keep their subpixel and interleaved events, if they
+ * had them, and their DVSBatchMetadata as the encoder wrote it, except
+ * that dropped_events also counts every event this node has dropped,
+ * thinned out or in whole batches, up to and including that batch.
+ * Once anything has been dropped, batches are rebuilt to say so, even
+ * if none of their own events are.
+ *
+ * expects: DVSEigenData
+ * signals: DVSEigenData
+ */
+class DVSRateController: public core::Node {
+public:
+    DVSRateController(
+        DegradationPolicy policy = DegradationPolicy::RandomDecimation,
+        double max_lag = 0.020,
+        double max_utilization = 0.9,
+        double min_keep_fraction = 0.05,
+        double control_period = 0.010,
+        const std::string& name = "DVSRateController");
+
+    void receive(core::MessagePtr m) override;
+
+    DegradationPolicy get_policy() const { return policy; }
+    DVSRateControllerMetrics get_metrics() const;
+    BlockPoolStats get_pool_stats() const { return eigen_data_pool.get_stats(); }
+
+protected:
+
+    void update_control(double now, double lag);
+    bool keep_event(bool on_off, int x, int y);
+
+    DegradationPolicy policy;
+    double max_lag;
+    double max_utilization;
+    double min_keep_fraction;
+    double control_period;
+
+    double last_control_time = 0.0;
+    double last_receive_time = 0.0;
+    double smoothed_interval = 0.0;
+    double smoothed_processing_time = 0.0;
+    int spatial_stride = 1;
+    uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+    std::vector<unsigned short> kept_on_events;
+    std::vector<unsigned short> kept_off_events;
+    std::vector<float> kept_on_subpixel;
+    std::vector<float> kept_off_subpixel;
+    std::vector<uint8_t> kept_on_mask;
+    std::vector<uint8_t> kept_off_mask;
+    std::vector<unsigned int> kept_interleaved;
+    MessagePool<DVSEigenData> eigen_data_pool;
+
+    mutable std::mutex metrics_mutex;
+    DVSRateControllerMetrics metrics;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_RATE_CONTROL__H
@@ -0,0 +1,117 @@
+#ifndef ROBOFLEX_DVS_SPARSE__H
+#define ROBOFLEX_DVS_SPARSE__H
+
+#include <mutex>
+#include <vector>
+#include <Eigen/Dense>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * Which index arrays DVSSparseFrameData carries. Either way, the
+ * entries are sorted row-major, by x (the row of the 320x480 image)
+ * then y, and the value arrays are shared by both layouts.
+ */
+enum class SparseLayout {
+    COO,
+    CSR,
+    Both
+};
+
+/**
+ * The events of one time window as a sparse tensor: one entry per
+ * active pixel, with its on and off event counts, and the sensor
+ * timestamp of its latest event.
+ *
+ *   "cols":        y of each entry
+ *   "rows":        x of each entry (COO)
+ *   "row_ptr":     321 offsets; row x is [row_ptr[x], row_ptr[x+1]) (CSR)
+ *   "on_counts", "off_counts", "latest_t": the values
+ *
+ * t is the time of the emit: event time or wall clock time, depending
+ * on how the node is driven.
+ */
+class DVSSparseFrameData: public core::Message {
+public:
+    typedef Eigen::Matrix<uint16_t, Eigen::Dynamic, 1> IndexVector;
+    typedef Eigen::Matrix<uint32_t, Eigen::Dynamic, 1> OffsetVector;
+    typedef Eigen::Matrix<uint16_t, Eigen::Dynamic, 1> CountVector;
+    typedef Eigen::Matrix<uint32_t, Eigen::Dynamic, 1> TimeVector;
+
+    inline static const char MessageName[] = "DVSSparseFrameData";
+
+    DVSSparseFrameData(core::Message& other): core::Message(other) {}
+    DVSSparseFrameData(
+        SparseLayout layout,
+        const IndexVector& rows,
+        const IndexVector& cols,
+        const OffsetVector& row_ptr,
+        const CountVector& on_counts,
+        const CountVector& off_counts,
+        const TimeVector& latest_t,
+        double t);
+
+    double get_t() const { return root_val("t").AsDouble(); }
+    int get_num_active() const { return root_val("num_active").AsInt32(); }
+    bool has_coo() const { return !root_val("rows").IsNull(); }
+    bool has_csr() const { return !root_val("row_ptr").IsNull(); }
+
+    const IndexVector get_rows() const;
+    const IndexVector get_cols() const;
+    const OffsetVector get_row_ptr() const;
+    const CountVector get_on_counts() const;
+    const CountVector get_off_counts() const;
+    const TimeVector get_latest_t() const;
+
+    void print_on(ostream& os) const override;
+};
+
+/**
+ * Builds deduplicated sparse frames from event batches. Pixels are
+ * marked in an active-pixel bitset, and appended to a compact list
+ * the first time they fire in a window; counts and timestamps live
+ * in dense per-pixel arrays that are only ever touched through that
+ * list. So an event costs O(1), and emitting and resetting cost
+ * O(active pixels), independent of the sensor size.
+ *
+ * Counts saturate at 65535.
+ *
+ * expects: DVSEigenData
+ * signals: DVSSparseFrameData
+ */
+class DVSSparseFrameBuilder: public DVSPeriodicNode {
+public:
+    DVSSparseFrameBuilder(
+        float emit_frequency_hz = 24.0,
+        SparseLayout layout = SparseLayout::COO,
+        double event_period = 0,
+        const std::string &name = "DVSSparseFrameBuilder");
+
+    void receive(core::MessagePtr m) override;
+
+    SparseLayout get_layout() const { return layout; }
+
+protected:
+
+    void emit(double time) override;
+
+    void add_events(const DVSEigenData::DVSFrame& events, bool on_off, uint32_t t);
+    void sort_active_pixels();
+
+    SparseLayout layout;
+
+    std::mutex state_mutex;
+    std::vector<uint64_t> active_bits;
+    std::vector<uint32_t> active_pixels;
+    std::vector<uint16_t> on_counts;
+    std::vector<uint16_t> off_counts;
+    std::vector<uint32_t> latest_t;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_SPARSE__H
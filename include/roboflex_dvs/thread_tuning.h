@@ -0,0 +1,82 @@
+#ifndef ROBOFLEX_DVS_THREAD_TUNING__H
+#define ROBOFLEX_DVS_THREAD_TUNING__H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace roboflex {
+namespace dvs {
+
+enum class DVSSchedulingPolicy {
+    Default,    // SCHED_OTHER, whatever the thread inherited
+    Fifo,       // SCHED_FIFO
+    RoundRobin  // SCHED_RR
+};
+
+/**
+ * How to set up a realtime-ish thread: which cores it may run on
+ * (empty means any), its scheduling policy and priority (1-99, for
+ * Fifo and RoundRobin), and whether to lock the process's memory.
+ *
+ * Locking memory is process-wide, whichever thread's options ask
+ * for it: mlockall(MCL_CURRENT) locks every page the process has
+ * mapped when the thread starts - the message pools, the encoder's
+ * frames, and whatever else the host process (Python included) has
+ * allocated by then - and it stays locked after the thread stops.
+ * Later allocations are not locked (no MCL_FUTURE), so they can't
+ * start failing once RLIMIT_MEMLOCK is reached; build the pipeline
+ * before starting the thread to have it covered.
+ *
+ * Cores must be online cpu numbers, which validate_thread_options()
+ * checks. Realtime policies and mlockall usually need privileges
+ * (CAP_SYS_NICE, CAP_IPC_LOCK, or matching rlimits); if a setting
+ * can't be applied, a warning is printed and the thread carries on
+ * without it.
+ */
+struct DVSThreadOptions {
+    std::vector<int> cpu_cores;
+    DVSSchedulingPolicy scheduling_policy = DVSSchedulingPolicy::Default;
+    int scheduling_priority = 0;
+    bool lock_memory = false;
+};
+
+// Throws if any of the cpu cores isn't one this machine has online.
+void validate_thread_options(const DVSThreadOptions& options);
+
+// Applies affinity and scheduling to the calling thread, and locks
+// memory if asked to. Returns false if anything could not be applied.
+bool apply_thread_options(const DVSThreadOptions& options, const std::string& thread_name);
+
+/**
+ * A lock-free histogram of intervals, in power-of-two microsecond
+ * buckets: bucket 0 counts intervals under 1 usec, and bucket k
+ * counts [2^(k-1), 2^k) usec. The last bucket takes everything
+ * longer. Safe to record from one thread while others read.
+ */
+class JitterHistogram {
+public:
+    static const int NumBuckets = 25;
+
+    void record(double interval_seconds);
+    void reset();
+
+    std::vector<unsigned long> get_counts() const;
+
+    // The upper bound of each bucket, in microseconds.
+    static std::vector<double> get_bucket_limits();
+
+    double get_max_interval() const { return max_interval.load(std::memory_order_relaxed); }
+    unsigned long get_num_samples() const { return num_samples.load(std::memory_order_relaxed); }
+
+protected:
+    std::atomic<unsigned long> counts[NumBuckets] = {};
+    std::atomic<unsigned long> num_samples = 0;
+    std::atomic<double> max_interval = 0.0;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_THREAD_TUNING__H
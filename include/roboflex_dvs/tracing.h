@@ -0,0 +1,93 @@
+#ifndef ROBOFLEX_DVS_TRACING__H
+#define ROBOFLEX_DVS_TRACING__H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * One timed stage of the pipeline, for one batch. transfer_id is the
+ * USB transfer the batch came from, so that the spans of one batch
+ * can be followed from the sensor to whatever consumes it. Times are
+ * host times in seconds, as from core::get_current_time().
+ */
+struct DVSTraceSpan {
+    const char* name = nullptr;
+    uint64_t transfer_id = 0;
+    double t_begin = 0;
+    double t_end = 0;
+    uint32_t thread_id = 0;
+};
+
+/**
+ * A fixed-size, lock-free ring of the most recent trace spans.
+ * Recording is a couple of atomic operations and a copy, from any
+ * number of threads; when the ring is full, the oldest spans are
+ * overwritten. Span names must be string literals (or otherwise
+ * outlive the ring): only the pointer is stored.
+ */
+class DVSTraceRing {
+public:
+    DVSTraceRing(size_t capacity = 65536);
+
+    size_t get_capacity() const { return capacity; }
+
+    void record(const char* name, uint64_t transfer_id, double t_begin, double t_end);
+
+    // The spans currently in the ring, oldest first. Spans being
+    // overwritten while this runs are skipped.
+    std::vector<DVSTraceSpan> get_spans() const;
+
+    void clear();
+
+    // Writes the spans in the Chrome trace event format ("X" events,
+    // in microseconds), which chrome://tracing and Perfetto both open.
+    void write_chrome_trace(const std::string& filename) const;
+
+protected:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        DVSTraceSpan span;
+    };
+
+    size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> next_index{0};
+};
+
+/**
+ * Pipeline-wide tracing. Off by default, in which case the nodes pay
+ * for one relaxed atomic load per batch. enable_tracing() creates a
+ * new shared ring if the capacity changed; the old one is retired but
+ * never freed, since nodes may still be recording into it, so call it
+ * before data starts flowing (and don't change the capacity often).
+ */
+void enable_tracing(size_t capacity = 65536);
+void disable_tracing();
+DVSTraceRing& get_trace_ring();
+
+namespace detail {
+extern std::atomic<bool> tracing_enabled;
+}
+
+inline bool is_tracing_enabled()
+{
+    return detail::tracing_enabled.load(std::memory_order_relaxed);
+}
+
+inline void trace_span(const char* name, uint64_t transfer_id, double t_begin, double t_end)
+{
+    if (is_tracing_enabled()) {
+        get_trace_ring().record(name, transfer_id, t_begin, t_end);
+    }
+}
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_TRACING__H
@@ -0,0 +1,131 @@
+#ifndef ROBOFLEX_DVS_TRACKER__H
+#define ROBOFLEX_DVS_TRACKER__H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+/**
+ * Track updates from the DVSClusterTracker: one row per track
+ * that received events in the batch, with the columns
+ *
+ *   id, x, y, vx, vy, cxx, cxy, cyy, activity
+ *
+ * Positions are in pixels, velocities in pixels per second, and
+ * (cxx, cxy, cyy) is the spatial covariance of the cluster's events.
+ */
+class DVSClusterTracks: public core::Message {
+public:
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 9, Eigen::RowMajor> Tracks;
+
+    inline static const char MessageName[] = "DVSClusterTracks";
+
+    DVSClusterTracks(core::Message& other): core::Message(other) {}
+    DVSClusterTracks(const Tracks& tracks, double t, double t0, double t1);
+
+    double get_t() const { return root_val("t").AsDouble(); }
+    double get_t0() const { return root_val("t0").AsDouble(); }
+    double get_t1() const { return root_val("t1").AsDouble(); }
+
+    const Tracks get_tracks() const {
+        return serialization::deserialize_eigen_matrix<float, Eigen::Dynamic, 9, Eigen::RowMajor>(root_val("tracks"));
+    }
+
+    void print_on(ostream& os) const override;
+};
+
+
+/**
+ * Tracks blobs of events with a set of clusters, each with a
+ * position, velocity, covariance and (exponentially decaying)
+ * activity.
+ *
+ * Clusters are indexed by a uniform spatial hash grid whose cells
+ * are cluster_radius wide, so assigning an event only looks at the
+ * clusters in the 3x3 cells around it. Events are matched against
+ * where each cluster should be by now, given its velocity, so at the
+ * start of every batch the clusters are re-binned at those predicted
+ * positions; fast clusters are found rather than duplicated. An event
+ * that no cluster claims spawns a new one (up to max_clusters), and a
+ * couple of clusters are checked for idleness on every event, so
+ * pruning is incremental too. Only clusters whose activity is at
+ * least min_activity are reported.
+ *
+ * When sensor time jumps backwards (it wraps, and starts over when
+ * the sensor restarts), all clusters are dropped, and tracks start
+ * over with new ids.
+ *
+ * expects: DVSEigenData
+ * signals: DVSClusterTracks
+ */
+class DVSClusterTracker: public core::Node {
+public:
+    DVSClusterTracker(
+        float cluster_radius = 12.0,
+        int max_clusters = 64,
+        float min_activity = 20.0,
+        double activity_time_constant = 20000.0,
+        double idle_timeout = 100000.0,
+        float mixing_factor = 0.05,
+        const std::string& name = "DVSClusterTracker");
+
+    void receive(core::MessagePtr m) override;
+
+    int get_num_clusters() const { return num_alive; }
+
+protected:
+
+    struct Cluster {
+        int id;
+        bool alive;
+        float x, y;
+        float vx, vy;
+        float cxx, cxy, cyy;
+        float activity;
+        double last_t;
+        float anchor_x, anchor_y;
+        double anchor_t;
+        int cell;
+        unsigned long last_batch;
+    };
+
+    void process_event(int x, int y, double t);
+    void rebin_predicted(double t);
+    int find_cluster(int x, int y, double t) const;
+    void update_cluster(Cluster& c, int x, int y, double t);
+    void spawn_cluster(int x, int y, double t);
+    void remove_cluster(int index);
+    void remove_all_clusters();
+    void prune_some(double t);
+
+    int cell_of(float x, float y) const;
+    void move_to_cell(int index, int cell);
+
+    float cluster_radius;
+    int max_clusters;
+    float min_activity;
+    double activity_time_constant;
+    double idle_timeout;
+    float mixing_factor;
+
+    int grid_rows;
+    int grid_cols;
+    std::vector<std::vector<int>> grid;
+
+    std::vector<Cluster> clusters;
+    std::vector<int> free_slots;
+    int num_alive = 0;
+    int next_id = 0;
+    int prune_cursor = 0;
+    unsigned long batch_count = 0;
+    double latest_t = 0;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_TRACKER__H
@@ -0,0 +1,126 @@
+#ifndef ROBOFLEX_DVS_WINDOW__H
+#define ROBOFLEX_DVS_WINDOW__H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "roboflex_core/core.h"
+#include "roboflex_dvs/dvs.h"
+
+namespace roboflex {
+namespace dvs {
+
+struct DVSWindowEvent {
+    uint32_t t;
+    uint16_t x;
+    uint16_t y;
+    uint8_t polarity;
+};
+
+/**
+ * A contiguous run of events in a DVSEventWindow's ring.
+ */
+struct DVSWindowSpan {
+    const DVSWindowEvent* data = nullptr;
+    size_t size = 0;
+};
+
+class DVSEventWindow;
+
+/**
+ * A zero-copy view of the events in a time range: at most two spans
+ * (two when the range wraps around the end of the ring), oldest
+ * first. The view points into the ring itself, so the producer may
+ * overwrite it; after reading through it, check is_valid(), and if
+ * it returns false, what was read may be torn and should be dropped
+ * (or re-queried). Views of recent events stay valid for as long as
+ * it takes the producer to write a whole ring's worth of events.
+ */
+class DVSEventWindowView {
+public:
+    const std::array<DVSWindowSpan, 2>& get_spans() const { return spans; }
+    size_t size() const { return spans[0].size + spans[1].size; }
+    bool is_valid() const;
+
+protected:
+    friend class DVSEventWindow;
+
+    std::array<DVSWindowSpan, 2> spans;
+    uint64_t begin_index = 0;
+    const DVSEventWindow* window = nullptr;
+};
+
+/**
+ * A shared store of the last window_duration (in sensor timestamp
+ * units, microseconds) of events, so that consumers that each need
+ * "the events of the last N ms" can read from one buffer instead of
+ * each keeping a copy.
+ *
+ * Events are appended to a ring of fixed capacity, in arrival order;
+ * appends and expiry are amortized O(1). If the window holds more
+ * events than fit, the oldest are dropped early (and counted).
+ *
+ * Queries can come from any thread, and never block the producer:
+ * there are no locks, only a pair of write counters that readers use
+ * to validate what they read (see DVSEventWindowView). Timestamps are
+ * expected to be nondecreasing; if they jump backwards, the window
+ * starts over.
+ *
+ * This node just forwards what it receives, so it can sit inline.
+ *
+ * expects: DVSEigenData
+ * signals: DVSEigenData (the input, unchanged)
+ */
+class DVSEventWindow: public core::Node {
+public:
+    DVSEventWindow(
+        double window_duration = 50000,
+        size_t capacity = 1 << 20,
+        const std::string &name = "DVSEventWindow");
+
+    void receive(core::MessagePtr m) override;
+
+    double get_window_duration() const { return window_duration; }
+    size_t get_capacity() const { return capacity; }
+    size_t get_num_events() const;
+    unsigned long get_num_overflowed() const { return num_overflowed.load(std::memory_order_relaxed); }
+
+    // The events with t_begin <= t < t_end, without copying.
+    DVSEventWindowView query(double t_begin, double t_end) const;
+
+    // The events of the last `duration`, up to the newest.
+    DVSEventWindowView query_latest(double duration) const;
+
+    // A consistent copy of query(t_begin, t_end), one row per
+    // event: timestamp, x, y, polarity. Retries if overwritten.
+    DVSRawPacket::DVSEventList get_events(double t_begin, double t_end) const;
+    DVSRawPacket::DVSEventList get_latest_events(double duration) const;
+
+protected:
+    friend class DVSEventWindowView;
+
+    void append(const DVSEigenData::DVSFrame& events, bool on_off, uint32_t t);
+    void expire(uint32_t newest_t);
+    uint64_t lower_bound(uint64_t begin, uint64_t end, double t) const;
+    DVSEventWindowView make_view(uint64_t begin, uint64_t end) const;
+
+    double window_duration;
+    size_t capacity;
+    std::unique_ptr<DVSWindowEvent[]> events;
+
+    // Events [tail, head) are in the window, at index % capacity.
+    // write_end runs ahead of head while the producer is writing.
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> write_end{0};
+
+    std::atomic<unsigned long> num_overflowed{0};
+    bool has_newest = false;
+    uint32_t newest_t = 0;
+};
+
+} // namespace dvs
+} // namespace roboflex
+
+#endif // ROBOFLEX_DVS_WINDOW__H
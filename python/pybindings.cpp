@@ -8,6 +8,16 @@
 #include <pybind11/stl_bind.h>
 #include "roboflex_core/core.h"
 #include "roboflex_dvs/dvs.h"
+#include "roboflex_dvs/corners.h"
+#include "roboflex_dvs/rate_control.h"
+#include "roboflex_dvs/event_log.h"
+#include "roboflex_dvs/intensity.h"
+#include "roboflex_dvs/tracker.h"
+#include "roboflex_dvs/pyramid.h"
+#include "roboflex_dvs/sparse.h"
+#include "roboflex_dvs/window.h"
+#include "roboflex_dvs/flicker.h"
+#include "roboflex_dvs/bias.h"
 
 namespace py = pybind11;
 
@@ -25,9 +35,51 @@ PYBIND11_MODULE(roboflex_dvs_ext, m) {
             py::arg("other"))
         .def_property_readonly("t0", &DVSRawData::get_t0)
         .def_property_readonly("t1", &DVSRawData::get_t1)
+        .def_property_readonly("transfer_id", &DVSRawData::get_transfer_id)
         .def("__repr__",  &DVSRawData::to_string)
     ;
 
+    py::class_<DVSDecoderState>(m, "DVSDecoderState")
+        .def(py::init<>())
+        .def_readwrite("long_ts", &DVSDecoderState::longTs)
+        .def_readwrite("short_ts", &DVSDecoderState::shortTs)
+        .def_readwrite("timestamp", &DVSDecoderState::timeStamp)
+        .def_readwrite("column", &DVSDecoderState::posX)
+    ;
+
+    py::class_<DVSDecoderStats>(m, "DVSDecoderStats")
+        .def_readonly("words", &DVSDecoderStats::words)
+        .def_readonly("invalid_words", &DVSDecoderStats::invalid_words)
+        .def_readonly("resyncs", &DVSDecoderStats::resyncs)
+        .def_readonly("bytes_discarded", &DVSDecoderStats::bytes_discarded)
+        .def_readonly("bytes_carried", &DVSDecoderStats::bytes_carried)
+    ;
+
+    py::class_<DVSRawPacket, core::Message, std::shared_ptr<DVSRawPacket>>(m, "DVSRawPacket")
+        .def(py::init([](const std::shared_ptr<core::Message> o) {
+            return DVSRawPacket::from_message(o); }),
+            "Construct a DVSRawPacket from a core message (the same packet, with its decode cache, if it is one)",
+            py::arg("other"))
+        .def("events", &DVSRawPacket::get_events,
+            "Decodes (once, then cached) into one row per event: timestamp, x, y, polarity.")
+        .def_property_readonly("t0", &DVSRawPacket::get_t0)
+        .def_property_readonly("t1", &DVSRawPacket::get_t1)
+        .def_property_readonly("transfer_id", &DVSRawPacket::get_transfer_id)
+        .def_property_readonly("decoder_state", &DVSRawPacket::get_decoder_state)
+        .def_property_readonly("decoder_stats", &DVSRawPacket::get_decoder_stats)
+        .def_property_readonly("is_decoded", &DVSRawPacket::is_decoded)
+        .def("__repr__", &DVSRawPacket::to_string)
+    ;
+
+    py::class_<DVSBatchMetadata>(m, "DVSBatchMetadata")
+        .def_readonly("t_first", &DVSBatchMetadata::t_first)
+        .def_readonly("t_last", &DVSBatchMetadata::t_last)
+        .def_readonly("transfer_id", &DVSBatchMetadata::transfer_id)
+        .def_readonly("transfer_t1", &DVSBatchMetadata::transfer_t1)
+        .def_readonly("dropped_events", &DVSBatchMetadata::dropped_events)
+        .def_readonly("dropped_bytes", &DVSBatchMetadata::dropped_bytes)
+    ;
+
     py::class_<DVSEigenData, core::Message, std::shared_ptr<DVSEigenData>>(m, "DVSEigenData")
         .def(py::init([](const std::shared_ptr<core::Message> o) {
             return std::make_shared<DVSEigenData>(*o); }),
@@ -38,6 +90,16 @@ PYBIND11_MODULE(roboflex_dvs_ext, m) {
         .def_property_readonly("t", &DVSEigenData::get_t)
         .def_property_readonly("t0", &DVSEigenData::get_t0)
         .def_property_readonly("t1", &DVSEigenData::get_t1)
+        .def_property_readonly("transfer_id", &DVSEigenData::get_transfer_id)
+        .def_property_readonly("metadata", &DVSEigenData::get_metadata)
+        .def_property_readonly("num_on", &DVSEigenData::get_num_on_events)
+        .def_property_readonly("num_off", &DVSEigenData::get_num_off_events)
+        .def_property_readonly("has_interleaved", &DVSEigenData::has_interleaved)
+        .def("interleaved", &DVSEigenData::get_interleaved_events,
+            "All events in arrival order, one row per event: x, y, polarity, t (sensor usec).")
+        .def_property_readonly("has_subpixel", &DVSEigenData::has_subpixel)
+        .def("on_subpixel", &DVSEigenData::get_on_subpixel)
+        .def("off_subpixel", &DVSEigenData::get_off_subpixel)
         .def("__repr__", &DVSEigenData::to_string)
 
         // .def(py::pickle(
@@ -62,22 +124,407 @@ PYBIND11_MODULE(roboflex_dvs_ext, m) {
         // ))
     ;
 
-    py::class_<DVSSensor, core::RunnableNode, std::shared_ptr<DVSSensor>>(m, "DVSSensor")
+    py::class_<BlockPoolStats>(m, "BlockPoolStats")
+        .def_readonly("hits", &BlockPoolStats::hits)
+        .def_readonly("misses", &BlockPoolStats::misses)
+        .def_readonly("recycled", &BlockPoolStats::recycled)
+        .def_readonly("released", &BlockPoolStats::released)
+        .def_readonly("block_size", &BlockPoolStats::block_size)
+        .def_readonly("free_blocks", &BlockPoolStats::free_blocks)
+        .def_readonly("max_free_blocks", &BlockPoolStats::max_free_blocks)
+    ;
+
+    py::enum_<DVSSchedulingPolicy>(m, "DVSSchedulingPolicy")
+        .value("Default", DVSSchedulingPolicy::Default)
+        .value("Fifo", DVSSchedulingPolicy::Fifo)
+        .value("RoundRobin", DVSSchedulingPolicy::RoundRobin)
+    ;
+
+    py::class_<DVSThreadOptions>(m, "DVSThreadOptions")
+        .def(py::init<>())
+        .def_readwrite("cpu_cores", &DVSThreadOptions::cpu_cores)
+        .def_readwrite("scheduling_policy", &DVSThreadOptions::scheduling_policy)
+        .def_readwrite("scheduling_priority", &DVSThreadOptions::scheduling_priority)
+        .def_readwrite("lock_memory", &DVSThreadOptions::lock_memory,
+            "Lock every page the whole process has mapped when the thread starts (mlockall(MCL_CURRENT)). Process-wide, and it stays locked.")
+    ;
+
+    py::class_<DVSRegisterInterface, std::shared_ptr<DVSRegisterInterface>>(m, "DVSRegisterInterface")
+        .def("read_register", &DVSRegisterInterface::read_register,
+            "Read an I2C register; -1 on failure.",
+            py::arg("slave_address"),
+            py::arg("address"))
+        .def("write_register", &DVSRegisterInterface::write_register,
+            "Write an I2C register; False on failure.",
+            py::arg("slave_address"),
+            py::arg("address"),
+            py::arg("value"))
+    ;
+
+    py::class_<DVSSensor, core::RunnableNode, DVSRegisterInterface, std::shared_ptr<DVSSensor>>(m, "DVSSensor")
+        .def(py::init<const std::string &, int, const DVSThreadOptions &>(),
+            "Create a DVS sensor that outputs raw, unparsed data, reading up to transfer_size bytes per bulk transfer",
+            py::arg("name") = "dvs_sensor",
+            py::arg("transfer_size") = 1024,
+            py::arg("thread_options") = DVSThreadOptions())
+        .def_property_readonly("transfer_size", &DVSSensor::get_transfer_size)
+        .def_property_readonly("thread_options", &DVSSensor::get_thread_options)
+        .def_property_readonly("jitter_histogram", [](const DVSSensor& s) { return s.get_jitter_histogram().get_counts(); })
+        .def_property_readonly("jitter_max_interval", [](const DVSSensor& s) { return s.get_jitter_histogram().get_max_interval(); })
+        .def_property_readonly_static("jitter_bucket_limits", [](py::object) { return JitterHistogram::get_bucket_limits(); })
+        .def("reset_jitter_histogram", &DVSSensor::reset_jitter_histogram)
+        .def_property_readonly("pool_stats", &DVSSensor::get_pool_stats)
+    ;
+
+    py::class_<DVSRawPacketizer, core::Node, std::shared_ptr<DVSRawPacketizer>>(m, "DVSRawPacketizer")
         .def(py::init<const std::string &>(),
-            "Create a DVS sensor that outputs raw, unparsed data",
-            py::arg("name") = "dvs_sensor")
+            "Create a transformer that consumes DVSRawData and emits self-contained DVSRawPacket, for sending raw data to another host.",
+            py::arg("name") = "DVSRawPacketizer")
+    ;
+
+    py::class_<DVSCameraCalibration>(m, "DVSCameraCalibration")
+        .def(py::init<>())
+        .def_readwrite("fx", &DVSCameraCalibration::fx)
+        .def_readwrite("fy", &DVSCameraCalibration::fy)
+        .def_readwrite("cx", &DVSCameraCalibration::cx)
+        .def_readwrite("cy", &DVSCameraCalibration::cy)
+        .def_readwrite("k1", &DVSCameraCalibration::k1)
+        .def_readwrite("k2", &DVSCameraCalibration::k2)
+        .def_readwrite("p1", &DVSCameraCalibration::p1)
+        .def_readwrite("p2", &DVSCameraCalibration::p2)
+        .def_readwrite("k3", &DVSCameraCalibration::k3)
+        .def_readwrite("rectification", &DVSCameraCalibration::rectification)
+        .def_readwrite("new_fx", &DVSCameraCalibration::new_fx)
+        .def_readwrite("new_fy", &DVSCameraCalibration::new_fy)
+        .def_readwrite("new_cx", &DVSCameraCalibration::new_cx)
+        .def_readwrite("new_cy", &DVSCameraCalibration::new_cy)
+    ;
+
+    py::class_<DVSUndistortionTable, std::shared_ptr<DVSUndistortionTable>>(m, "DVSUndistortionTable")
+        .def(py::init<const DVSCameraCalibration &>(),
+            "Precompute the per-pixel undistortion and rectification lookup table for a calibration. Raises ValueError on non-positive focal lengths.",
+            py::arg("calibration"))
+        .def_property_readonly("calibration", &DVSUndistortionTable::get_calibration)
+        .def_property_readonly("num_valid", &DVSUndistortionTable::get_num_valid)
     ;
 
     py::class_<DVSEncoder, core::Node, std::shared_ptr<DVSEncoder>>(m, "DVSEncoder")
         .def(py::init<const std::string &>(),
-            "Create a transformer that consumes DVSRawData and emits DVSEigenData.",
+            "Create a transformer that consumes DVSRawData (or DVSRawPacket) and emits DVSEigenData.",
             py::arg("name") = "dvs_encoder")
+        .def_property_readonly("pool_stats", &DVSEncoder::get_pool_stats)
+        .def("set_undistortion", &DVSEncoder::set_undistortion,
+            "Undistort every event through the lookup table as it is decoded; None turns it off.",
+            py::arg("table"),
+            py::arg("subpixel") = false)
+        .def_property_readonly("num_undistortion_dropped", &DVSEncoder::get_num_undistortion_dropped)
+        .def_property_readonly("decoder_stats", &DVSEncoder::get_decoder_stats)
+        .def_property("interleaved", &DVSEncoder::is_interleaved, &DVSEncoder::set_interleaved,
+            "Also emit the events in arrival order, on and off interleaved.")
+        .def_property("batch_duration", &DVSEncoder::get_batch_duration, &DVSEncoder::set_batch_duration,
+            "Collect consecutive timestamps into one frame, for up to this many usec; 0 means one timestamp per frame.")
+    ;
+
+    py::enum_<GrayScaleNormalization>(m, "GrayScaleNormalization")
+        .value("Fixed", GrayScaleNormalization::Fixed)
+        .value("MinMax", GrayScaleNormalization::MinMax)
+        .value("AbsMax", GrayScaleNormalization::AbsMax)
+    ;
+
+    py::class_<DVSPeriodicNode, nodes::FrequencyGenerator, std::shared_ptr<DVSPeriodicNode>>(m, "DVSPeriodicNode")
+        .def_property_readonly("event_time_driven", &DVSPeriodicNode::is_event_time_driven)
+        .def_property_readonly("event_period", &DVSPeriodicNode::get_event_period)
     ;
 
-    py::class_<DVSEigenToGrayScale, nodes::FrequencyGenerator, std::shared_ptr<DVSEigenToGrayScale>>(m, "DVSEigenToGrayScale")
-        .def(py::init<float, const std::string &>(),
-            "Consumes DVSEigenData and periodically emits a grayscale image as a TensorMessage under the key \"image\"",
+    py::class_<DVSEigenToGrayScale, DVSPeriodicNode, std::shared_ptr<DVSEigenToGrayScale>>(m, "DVSEigenToGrayScale")
+        .def(py::init<float, const std::string &, GrayScaleNormalization, int, int, int, double>(),
+            "Consumes DVSEigenData and periodically emits a grayscale image as a TensorMessage under the key \"image\". With event_period > 0, emits every event_period microseconds of sensor time instead of on the wall clock.",
             py::arg("emit_frequency_hz") = 24.0,
-            py::arg("name") = "DVSEigenToGrayScale")
+            py::arg("name") = "DVSEigenToGrayScale",
+            py::arg("normalization") = GrayScaleNormalization::Fixed,
+            py::arg("event_weight") = 40,
+            py::arg("parallel_threshold") = 65536,
+            py::arg("num_threads") = 4,
+            py::arg("event_period") = 0)
+        .def_property_readonly("normalization", &DVSEigenToGrayScale::get_normalization)
+        .def_property_readonly("event_weight", &DVSEigenToGrayScale::get_event_weight)
     ;
+
+    py::class_<DVSCornerData, core::Message, std::shared_ptr<DVSCornerData>>(m, "DVSCornerData")
+        .def(py::init([](const std::shared_ptr<core::Message> o) {
+            return std::make_shared<DVSCornerData>(*o); }),
+            "Construct a DVSCornerData from a core message",
+            py::arg("other"))
+        .def("corners", &DVSCornerData::get_corners)
+        .def_property_readonly("t", &DVSCornerData::get_t)
+        .def_property_readonly("t0", &DVSCornerData::get_t0)
+        .def_property_readonly("t1", &DVSCornerData::get_t1)
+        .def("__repr__", &DVSCornerData::to_string)
+    ;
+
+    py::class_<DVSCornerDetector, core::Node, std::shared_ptr<DVSCornerDetector>>(m, "DVSCornerDetector")
+        .def(py::init<double, const std::string &>(),
+            "Consumes DVSEigenData and emits DVSCornerData, detecting corners per event with eFAST on a surface of active events.",
+            py::arg("refractory_period") = 50000.0,
+            py::arg("name") = "DVSCornerDetector")
+        .def_property_readonly("num_events", &DVSCornerDetector::get_num_events)
+        .def_property_readonly("num_corners", &DVSCornerDetector::get_num_corners)
+    ;
+
+    py::enum_<DegradationPolicy>(m, "DegradationPolicy")
+        .value("RandomDecimation", DegradationPolicy::RandomDecimation)
+        .value("SpatialSubsampling", DegradationPolicy::SpatialSubsampling)
+        .value("DropPolarity", DegradationPolicy::DropPolarity)
+        .value("DropOldest", DegradationPolicy::DropOldest)
+    ;
+
+    py::class_<DVSRateControllerMetrics>(m, "DVSRateControllerMetrics")
+        .def_readonly("batches_in", &DVSRateControllerMetrics::batches_in)
+        .def_readonly("batches_out", &DVSRateControllerMetrics::batches_out)
+        .def_readonly("batches_dropped", &DVSRateControllerMetrics::batches_dropped)
+        .def_readonly("events_in", &DVSRateControllerMetrics::events_in)
+        .def_readonly("events_out", &DVSRateControllerMetrics::events_out)
+        .def_readonly("events_dropped", &DVSRateControllerMetrics::events_dropped)
+        .def_readonly("keep_fraction", &DVSRateControllerMetrics::keep_fraction)
+        .def_readonly("lag", &DVSRateControllerMetrics::lag)
+        .def_readonly("utilization", &DVSRateControllerMetrics::utilization)
+        .def_readonly("degrading", &DVSRateControllerMetrics::degrading)
+    ;
+
+    py::class_<DVSRateController, core::Node, std::shared_ptr<DVSRateController>>(m, "DVSRateController")
+        .def(py::init<DegradationPolicy, double, double, double, double, const std::string &>(),
+            "Consumes DVSEigenData and re-emits it, degrading the stream according to the policy when downstream lags or is saturated.",
+            py::arg("policy") = DegradationPolicy::RandomDecimation,
+            py::arg("max_lag") = 0.020,
+            py::arg("max_utilization") = 0.9,
+            py::arg("min_keep_fraction") = 0.05,
+            py::arg("control_period") = 0.010,
+            py::arg("name") = "DVSRateController")
+        .def_property_readonly("policy", &DVSRateController::get_policy)
+        .def_property_readonly("metrics", &DVSRateController::get_metrics)
+        .def_property_readonly("pool_stats", &DVSRateController::get_pool_stats)
+    ;
+
+    py::class_<DVSEventLogWriter, core::Node, std::shared_ptr<DVSEventLogWriter>>(m, "DVSEventLogWriter")
+        .def(py::init<const std::string &, unsigned int, const std::string &>(),
+            "Consumes DVSEigenData and writes it to a block-indexed event log file.",
+            py::arg("filename"),
+            py::arg("events_per_block") = 65536,
+            py::arg("name") = "DVSEventLogWriter")
+        .def("close", &DVSEventLogWriter::close)
+        .def_property_readonly("num_blocks", &DVSEventLogWriter::get_num_blocks)
+        .def_property_readonly("num_wraps", &DVSEventLogWriter::get_num_wraps)
+        .def_property_readonly("num_discontinuities", &DVSEventLogWriter::get_num_discontinuities)
+    ;
+
+    py::class_<DVSEventLog, std::shared_ptr<DVSEventLog>>(m, "DVSEventLog")
+        .def(py::init<const std::string &>(),
+            "Open a block-indexed event log for time and region queries.",
+            py::arg("filename"))
+        .def("query", &DVSEventLog::query,
+            "Returns the events with t_begin <= t <= t_end inside the (inclusive) region, as a list of DVSEigenData.",
+            py::arg("t_begin"),
+            py::arg("t_end"),
+            py::arg("x_min") = 0,
+            py::arg("y_min") = 0,
+            py::arg("x_max") = 319,
+            py::arg("y_max") = 479)
+        .def_property_readonly("t_begin", &DVSEventLog::get_t_begin)
+        .def_property_readonly("t_end", &DVSEventLog::get_t_end)
+        .def_property_readonly("num_blocks", [](const DVSEventLog& log) { return log.get_index().size(); })
+    ;
+
+    py::class_<DVSIntensityReconstructor, DVSPeriodicNode, std::shared_ptr<DVSIntensityReconstructor>>(m, "DVSIntensityReconstructor")
+        .def(py::init<float, float, float, float, double, const std::string &>(),
+            "Consumes DVSEigenData, keeps a leaky per-pixel log intensity estimate, and periodically emits it as a grayscale image under the key \"image\"",
+            py::arg("emit_frequency_hz") = 24.0,
+            py::arg("contrast_threshold") = 0.1,
+            py::arg("decay_rate") = 2.0,
+            py::arg("display_gain") = 127.0,
+            py::arg("event_period") = 0,
+            py::arg("name") = "DVSIntensityReconstructor")
+        .def("log_intensity", &DVSIntensityReconstructor::get_log_intensity)
+    ;
+
+    py::class_<DVSClusterTracks, core::Message, std::shared_ptr<DVSClusterTracks>>(m, "DVSClusterTracks")
+        .def(py::init([](const std::shared_ptr<core::Message> o) {
+            return std::make_shared<DVSClusterTracks>(*o); }),
+            "Construct a DVSClusterTracks from a core message",
+            py::arg("other"))
+        .def("tracks", &DVSClusterTracks::get_tracks)
+        .def_property_readonly("t", &DVSClusterTracks::get_t)
+        .def_property_readonly("t0", &DVSClusterTracks::get_t0)
+        .def_property_readonly("t1", &DVSClusterTracks::get_t1)
+        .def("__repr__", &DVSClusterTracks::to_string)
+    ;
+
+    py::class_<DVSClusterTracker, core::Node, std::shared_ptr<DVSClusterTracker>>(m, "DVSClusterTracker")
+        .def(py::init<float, int, float, double, double, float, const std::string &>(),
+            "Consumes DVSEigenData, tracks event clusters through a spatial hash grid, and emits DVSClusterTracks with the columns (id, x, y, vx, vy, cxx, cxy, cyy, activity).",
+            py::arg("cluster_radius") = 12.0,
+            py::arg("max_clusters") = 64,
+            py::arg("min_activity") = 20.0,
+            py::arg("activity_time_constant") = 20000.0,
+            py::arg("idle_timeout") = 100000.0,
+            py::arg("mixing_factor") = 0.05,
+            py::arg("name") = "DVSClusterTracker")
+        .def_property_readonly("num_clusters", &DVSClusterTracker::get_num_clusters)
+    ;
+
+    py::class_<DVSEventPyramidData, core::Message, std::shared_ptr<DVSEventPyramidData>>(m, "DVSEventPyramidData")
+        .def(py::init([](const std::shared_ptr<core::Message> o) {
+            return std::make_shared<DVSEventPyramidData>(*o); }),
+            "Construct a DVSEventPyramidData from a core message",
+            py::arg("other"))
+        .def("level", &DVSEventPyramidData::get_level, py::arg("level"))
+        .def("has_level", &DVSEventPyramidData::has_level, py::arg("level"))
+        .def_property_readonly("level_mask", &DVSEventPyramidData::get_level_mask)
+        .def_property_readonly("t", &DVSEventPyramidData::get_t)
+        .def("__repr__", &DVSEventPyramidData::to_string)
+    ;
+
+    py::class_<DVSEventPyramid, DVSPeriodicNode, std::shared_ptr<DVSEventPyramid>>(m, "DVSEventPyramid")
+        .def(py::init<float, int, double, const std::string &>(),
+            "Consumes DVSEigenData, keeps event-count images at 1x, 1/2, 1/4 and 1/8 resolution, and periodically emits the levels in level_mask as DVSEventPyramidData.",
+            py::arg("emit_frequency_hz") = 24.0,
+            py::arg("level_mask") = 0xF,
+            py::arg("event_period") = 0,
+            py::arg("name") = "DVSEventPyramid")
+        .def_property_readonly("level_mask", &DVSEventPyramid::get_level_mask)
+    ;
+
+    py::enum_<SparseLayout>(m, "SparseLayout")
+        .value("COO", SparseLayout::COO)
+        .value("CSR", SparseLayout::CSR)
+        .value("Both", SparseLayout::Both)
+    ;
+
+    py::class_<DVSSparseFrameData, core::Message, std::shared_ptr<DVSSparseFrameData>>(m, "DVSSparseFrameData")
+        .def(py::init([](const std::shared_ptr<core::Message> o) {
+            return std::make_shared<DVSSparseFrameData>(*o); }),
+            "Construct a DVSSparseFrameData from a core message",
+            py::arg("other"))
+        .def("rows", &DVSSparseFrameData::get_rows)
+        .def("cols", &DVSSparseFrameData::get_cols)
+        .def("row_ptr", &DVSSparseFrameData::get_row_ptr)
+        .def("on_counts", &DVSSparseFrameData::get_on_counts)
+        .def("off_counts", &DVSSparseFrameData::get_off_counts)
+        .def("latest_t", &DVSSparseFrameData::get_latest_t)
+        .def_property_readonly("t", &DVSSparseFrameData::get_t)
+        .def_property_readonly("num_active", &DVSSparseFrameData::get_num_active)
+        .def_property_readonly("has_coo", &DVSSparseFrameData::has_coo)
+        .def_property_readonly("has_csr", &DVSSparseFrameData::has_csr)
+        .def("__repr__", &DVSSparseFrameData::to_string)
+    ;
+
+    py::class_<DVSSparseFrameBuilder, DVSPeriodicNode, std::shared_ptr<DVSSparseFrameBuilder>>(m, "DVSSparseFrameBuilder")
+        .def(py::init<float, SparseLayout, double, const std::string &>(),
+            "Consumes DVSEigenData and periodically emits each window's active pixels, with per-polarity counts and latest timestamps, as a row-major sorted DVSSparseFrameData.",
+            py::arg("emit_frequency_hz") = 24.0,
+            py::arg("layout") = SparseLayout::COO,
+            py::arg("event_period") = 0,
+            py::arg("name") = "DVSSparseFrameBuilder")
+        .def_property_readonly("layout", &DVSSparseFrameBuilder::get_layout)
+    ;
+
+    py::class_<DVSEventWindow, core::Node, std::shared_ptr<DVSEventWindow>>(m, "DVSEventWindow")
+        .def(py::init<double, size_t, const std::string &>(),
+            "Keeps the last window_duration (sensor time, usec) of DVSEigenData events in a shared ring buffer that any thread can query without blocking the producer. Passes its input through.",
+            py::arg("window_duration") = 50000.0,
+            py::arg("capacity") = 1 << 20,
+            py::arg("name") = "DVSEventWindow")
+        .def("events", &DVSEventWindow::get_events,
+            "A copy of the events with t_begin <= t < t_end, one row per event: timestamp, x, y, polarity.",
+            py::arg("t_begin"),
+            py::arg("t_end"))
+        .def("latest_events", &DVSEventWindow::get_latest_events,
+            "A copy of the events of the last `duration`, one row per event: timestamp, x, y, polarity.",
+            py::arg("duration"))
+        .def_property_readonly("window_duration", &DVSEventWindow::get_window_duration)
+        .def_property_readonly("capacity", &DVSEventWindow::get_capacity)
+        .def_property_readonly("num_events", &DVSEventWindow::get_num_events)
+        .def_property_readonly("num_overflowed", &DVSEventWindow::get_num_overflowed)
+    ;
+
+    py::class_<DVSFlickerMarkers, core::Message, std::shared_ptr<DVSFlickerMarkers>>(m, "DVSFlickerMarkers")
+        .def(py::init([](const std::shared_ptr<core::Message> o) {
+            return std::make_shared<DVSFlickerMarkers>(*o); }),
+            "Construct a DVSFlickerMarkers from a core message",
+            py::arg("other"))
+        .def("markers", &DVSFlickerMarkers::get_markers,
+            "One row per marker: id, x, y, frequency (Hz), num_pixels.")
+        .def_property_readonly("t", &DVSFlickerMarkers::get_t)
+        .def("__repr__", &DVSFlickerMarkers::to_string)
+    ;
+
+    py::class_<DVSFlickerDetector, DVSPeriodicNode, std::shared_ptr<DVSFlickerDetector>>(m, "DVSFlickerDetector")
+        .def(py::init<float, const std::vector<double>&, double, double, double, int, int, int, double, const std::string &>(),
+            "Consumes DVSEigenData, estimates each pixel's blink frequency, and periodically emits clusters of pixels blinking at the marker frequencies as DVSFlickerMarkers.",
+            py::arg("emit_frequency_hz") = 30.0,
+            py::arg("marker_frequencies") = std::vector<double>(),
+            py::arg("min_frequency") = 50.0,
+            py::arg("max_frequency") = 5000.0,
+            py::arg("frequency_tolerance") = 0.1,
+            py::arg("min_stability") = 3,
+            py::arg("cell_size") = 8,
+            py::arg("min_pixels") = 3,
+            py::arg("event_period") = 0,
+            py::arg("name") = "DVSFlickerDetector")
+        .def_property_readonly("marker_frequencies", &DVSFlickerDetector::get_marker_frequencies)
+        .def_property_readonly("num_candidates", &DVSFlickerDetector::get_num_candidates)
+    ;
+
+    py::class_<DVSBiasController, core::Node, std::shared_ptr<DVSBiasController>>(m, "DVSBiasController")
+        .def(py::init<std::shared_ptr<DVSRegisterInterface>, double, double, double, int, int, int, int, const std::string &>(),
+            "Consumes DVSEigenData and nudges the sensor's sensitivity biases to keep the event rate within [low_event_rate, high_event_rate]. Passes its input through.",
+            py::arg("sensor"),
+            py::arg("low_event_rate") = 200000.0,
+            py::arg("high_event_rate") = 2000000.0,
+            py::arg("control_period") = 0.1,
+            py::arg("hold_periods") = 3,
+            py::arg("min_bias") = 0x00,
+            py::arg("max_bias") = 0x3F,
+            py::arg("bias_step") = 1,
+            py::arg("name") = "DVSBiasController")
+        .def_property_readonly("bias_offset", &DVSBiasController::get_bias_offset)
+        .def_property_readonly("biases", &DVSBiasController::get_biases)
+        .def_property_readonly("start_biases", &DVSBiasController::get_start_biases)
+        .def_property_readonly("event_rate", &DVSBiasController::get_event_rate)
+        .def_property_readonly("num_adjustments", &DVSBiasController::get_num_adjustments)
+        .def_property_readonly("num_write_errors", &DVSBiasController::get_num_write_errors)
+    ;
+
+    py::class_<DVSSimulatedSensor, core::RunnableNode, DVSRegisterInterface, std::shared_ptr<DVSSimulatedSensor>>(m, "DVSSimulatedSensor")
+        .def(py::init<double, double, int, const std::string &>(),
+            "A stand-in for DVSSensor that streams synthetic raw data, at an event rate that follows the sensitivity bias registers.",
+            py::arg("scene_event_rate") = 2000000.0,
+            py::arg("bias_halving_step") = 2.0,
+            py::arg("transfer_size") = 1024,
+            py::arg("name") = "DVSSimulatedSensor")
+        .def_property("scene_event_rate", &DVSSimulatedSensor::get_scene_event_rate, &DVSSimulatedSensor::set_scene_event_rate)
+        .def_property_readonly("event_rate", &DVSSimulatedSensor::get_event_rate)
+        .def_property_readonly("num_msec", &DVSSimulatedSensor::get_num_msec)
+        .def("generate", &DVSSimulatedSensor::generate,
+            "Produce num_msec milliseconds of data right away, in the calling thread, without pacing. Don't call it on a started sensor.",
+            py::arg("num_msec"))
+    ;
+
+    py::class_<DVSTraceSpan>(m, "DVSTraceSpan")
+        .def_property_readonly("name", [](const DVSTraceSpan& s) { return std::string(s.name ? s.name : ""); })
+        .def_readonly("transfer_id", &DVSTraceSpan::transfer_id)
+        .def_readonly("t_begin", &DVSTraceSpan::t_begin)
+        .def_readonly("t_end", &DVSTraceSpan::t_end)
+        .def_readonly("thread_id", &DVSTraceSpan::thread_id)
+    ;
+
+    m.def("enable_tracing", &enable_tracing,
+        "Start recording pipeline spans into a ring holding the last `capacity` spans.",
+        py::arg("capacity") = 65536);
+    m.def("disable_tracing", &disable_tracing);
+    m.def("is_tracing_enabled", &is_tracing_enabled);
+    m.def("get_trace_spans", []() { return get_trace_ring().get_spans(); });
+    m.def("clear_trace", []() { get_trace_ring().clear(); });
+    m.def("write_chrome_trace", [](const std::string& filename) { get_trace_ring().write_chrome_trace(filename); },
+        "Write the recorded spans as Chrome trace JSON, for chrome://tracing or Perfetto.",
+        py::arg("filename"));
 }
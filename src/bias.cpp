@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include "roboflex_dvs/bias.h"
+
+namespace roboflex {
+namespace dvs {
+
+
+// -- DVSBiasController --
+
+DVSBiasController::DVSBiasController(
+    std::shared_ptr<DVSRegisterInterface> sensor,
+    double low_event_rate,
+    double high_event_rate,
+    double control_period,
+    int hold_periods,
+    int min_bias,
+    int max_bias,
+    int bias_step,
+    const std::string &name):
+        core::Node(name),
+        sensor(sensor),
+        low_event_rate(low_event_rate),
+        high_event_rate(high_event_rate),
+        control_period(control_period),
+        hold_periods(std::max(1, hold_periods)),
+        min_bias(min_bias),
+        max_bias(max_bias),
+        bias_step(std::max(1, bias_step))
+{
+    if (sensor == nullptr) {
+        throw std::runtime_error("DVSBiasController needs a sensor to write the biases to");
+    }
+    if (low_event_rate >= high_event_rate) {
+        throw std::runtime_error("DVSBiasController: low_event_rate must be below high_event_rate");
+    }
+    if (min_bias > max_bias) {
+        throw std::runtime_error("DVSBiasController: min_bias must not be above max_bias");
+    }
+
+    for (int address: DVSBiasRegisters) {
+        int value = sensor->read_register(DVSBiasSlaveAddress, address);
+        if (value < 0) {
+            throw std::runtime_error("DVSBiasController: unable to read bias register " + std::to_string(address));
+        }
+        start_biases.push_back(value);
+    }
+}
+
+int DVSBiasController::bias_value(int register_index, int offset) const
+{
+    return std::clamp(start_biases[register_index] + offset, min_bias, max_bias);
+}
+
+std::vector<int> DVSBiasController::get_biases() const
+{
+    std::vector<int> biases;
+    for (int i=0; i<DVSNumBiasRegisters; i++) {
+        biases.push_back(bias_value(i, bias_offset));
+    }
+    return biases;
+}
+
+bool DVSBiasController::move_biases(int step)
+{
+    int offset = bias_offset + step;
+
+    bool moved = false;
+    for (int i=0; i<DVSNumBiasRegisters; i++) {
+        int value = bias_value(i, offset);
+        if (value == bias_value(i, bias_offset)) {
+            continue;
+        }
+        moved = true;
+        if (!sensor->write_register(DVSBiasSlaveAddress, DVSBiasRegisters[i], value)) {
+            num_write_errors += 1;
+        }
+    }
+
+    // All of them are at their bounds already.
+    if (!moved) {
+        return false;
+    }
+
+    bias_offset = offset;
+    num_adjustments += 1;
+    periods_above = 0;
+    periods_below = 0;
+    settling = true;
+    return true;
+}
+
+void DVSBiasController::control(double rate)
+{
+    event_rate = rate;
+
+    // Don't judge a bias change by the period it happened in.
+    if (settling) {
+        settling = false;
+        return;
+    }
+
+    if (rate > high_event_rate) {
+        periods_above += 1;
+        periods_below = 0;
+    } else if (rate < low_event_rate) {
+        periods_below += 1;
+        periods_above = 0;
+    } else {
+        periods_above = 0;
+        periods_below = 0;
+    }
+
+    if (periods_above >= hold_periods) {
+        move_biases(bias_step);
+    } else if (periods_below >= hold_periods) {
+        move_biases(-bias_step);
+    }
+}
+
+void DVSBiasController::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    double t = input.get_t();
+
+    // Sensor time is in usec; start over if it jumps backwards.
+    if (window_start_t < 0 || t < last_t) {
+        window_start_t = t;
+        window_events = 0;
+    }
+    last_t = t;
+
+    double elapsed = (t - window_start_t) * 1e-6;
+    if (elapsed >= control_period) {
+        control(window_events / elapsed);
+        window_start_t = t;
+        window_events = 0;
+    }
+
+    window_events += input.get_num_on_events() + input.get_num_off_events();
+
+    this->signal(m);
+}
+
+
+// -- DVSSimulatedSensor --
+
+DVSSimulatedSensor::DVSSimulatedSensor(
+    double scene_event_rate,
+    double bias_halving_step,
+    int transfer_size,
+    const std::string &name):
+        core::RunnableNode(name),
+        scene_event_rate(scene_event_rate),
+        bias_halving_step(bias_halving_step),
+        transfer_size(std::max(4, transfer_size))
+{
+    for (int i=0; i<DVSNumBiasRegisters; i++) {
+        registers[{DVSBiasSlaveAddress, DVSBiasRegisters[i]}] = DVSBiasDefaults[i];
+    }
+}
+
+int DVSSimulatedSensor::read_register(int slave_address, int address)
+{
+    const std::lock_guard<std::mutex> lock(registers_mutex);
+    auto it = registers.find({slave_address, address});
+    return it == registers.end() ? 0 : it->second;
+}
+
+bool DVSSimulatedSensor::write_register(int slave_address, int address, int value)
+{
+    const std::lock_guard<std::mutex> lock(registers_mutex);
+    registers[{slave_address, address}] = value;
+    return true;
+}
+
+double DVSSimulatedSensor::get_event_rate() const
+{
+    double bias_offset = 0;
+    {
+        const std::lock_guard<std::mutex> lock(registers_mutex);
+        for (int i=0; i<DVSNumBiasRegisters; i++) {
+            bias_offset += registers.at({DVSBiasSlaveAddress, DVSBiasRegisters[i]}) - DVSBiasDefaults[i];
+        }
+    }
+    bias_offset /= DVSNumBiasRegisters;
+    return scene_event_rate * std::pow(2.0, -bias_offset / bias_halving_step);
+}
+
+void DVSSimulatedSensor::generate(unsigned int num_msec)
+{
+    for (unsigned int i=0; i<num_msec; i++) {
+        generate_millisecond();
+    }
+}
+
+void DVSSimulatedSensor::child_thread_fn()
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long k = 1; !this->stop_signal; k++) {
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(k));
+        generate_millisecond();
+    }
+}
+
+void DVSSimulatedSensor::generate_millisecond()
+{
+    auto push_word = [&](uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) {
+        words.push_back(b0);
+        words.push_back(b1);
+        words.push_back(b2);
+        words.push_back(b3);
+    };
+
+    // One reference timestamp per millisecond, as the sensor does.
+    num_msec += 1;
+    double t0 = core::get_current_time();
+
+    uint32_t reference = num_msec & 0x3FFFFF;
+    push_word(0x08, (reference >> 16) & 0x3F, (reference >> 8) & 0xFF, reference & 0xFF);
+
+    // Up to 8 events per group word, each group in its own column,
+    // with sub-timestamps spread over the millisecond.
+    pending_events += get_event_rate() / 1000.0;
+    int num_events = (int)pending_events;
+    pending_events -= num_events;
+    int num_groups = (num_events + 7) / 8;
+
+    for (int g=0; g<num_groups; g++) {
+        int n = std::min(8, num_events - g * 8);
+        unsigned int sub_timestamp = g * 1000 / num_groups;
+        unsigned int column = rng() % 320;
+        push_word(
+            0x04,
+            (sub_timestamp >> 5) & 0x1F,
+            ((sub_timestamp & 0x1F) << 3) | ((column >> 8) & 0x03),
+            column & 0xFF);
+
+        uint8_t bits = ((1 << n) - 1) << (rng() % (9 - n));
+        int group_address = rng() % 60;
+        push_word(0x80, (group_address << 2) | (rng() & 0x01), 0x00, bits);
+    }
+
+    double t1 = core::get_current_time();
+
+    size_t offset = 0;
+    while (words.size() - offset >= (size_t)transfer_size) {
+        transfer_id += 1;
+        this->signal(std::make_shared<DVSRawData>(t0, t1, words.data() + offset, transfer_size, transfer_id));
+        offset += transfer_size;
+    }
+    words.erase(words.begin(), words.begin() + offset);
+}
+
+} // namespace dvs
+} // namespace roboflex
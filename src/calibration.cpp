@@ -0,0 +1,72 @@
+#include <cmath>
+#include <stdexcept>
+#include "roboflex_dvs/calibration.h"
+
+namespace roboflex {
+namespace dvs {
+
+// Fixed-point iterations used to invert the distortion model.
+static const int UNDISTORT_ITERATIONS = 20;
+
+DVSUndistortionTable::DVSUndistortionTable(const DVSCameraCalibration& calibration):
+    calibration(calibration),
+    pixel_table(320 * 480 * 2, INVALID),
+    subpixel_table(320 * 480 * 2, -1.0f)
+{
+    const DVSCameraCalibration& c = calibration;
+    if (!(c.fx > 0) || !(c.fy > 0)) {
+        throw std::invalid_argument("DVSUndistortionTable: fx and fy must be > 0");
+    }
+    if (c.new_fx < 0 || (c.new_fx > 0 && !(c.new_fy > 0))) {
+        throw std::invalid_argument("DVSUndistortionTable: new_fx and new_fy must be > 0, or new_fx 0");
+    }
+    double nfx = c.new_fx > 0 ? c.new_fx : c.fx;
+    double nfy = c.new_fx > 0 ? c.new_fy : c.fy;
+    double ncx = c.new_fx > 0 ? c.new_cx : c.cx;
+    double ncy = c.new_fx > 0 ? c.new_cy : c.cy;
+
+    for (int x=0; x<320; x++) {
+        for (int y=0; y<480; y++) {
+
+            // Distorted, normalized coordinates of this pixel.
+            double xd = (y - c.cx) / c.fx;
+            double yd = (x - c.cy) / c.fy;
+
+            // Invert the distortion iteratively, like cv::undistortPoints.
+            double xu = xd;
+            double yu = yd;
+            for (int it=0; it<UNDISTORT_ITERATIONS; it++) {
+                double r2 = xu*xu + yu*yu;
+                double radial = 1 + r2 * (c.k1 + r2 * (c.k2 + r2 * c.k3));
+                double dx = 2*c.p1*xu*yu + c.p2*(r2 + 2*xu*xu);
+                double dy = c.p1*(r2 + 2*yu*yu) + 2*c.p2*xu*yu;
+                xu = (xd - dx) / radial;
+                yu = (yd - dy) / radial;
+            }
+
+            Eigen::Vector3d ray = c.rectification * Eigen::Vector3d(xu, yu, 1.0);
+            if (ray.z() <= 0) {
+                continue;
+            }
+
+            double u = nfx * ray.x() / ray.z() + ncx;
+            double v = nfy * ray.y() / ray.z() + ncy;
+
+            int ix = (int)std::lround(v);
+            int iy = (int)std::lround(u);
+            if (ix < 0 || ix >= 320 || iy < 0 || iy >= 480) {
+                continue;
+            }
+
+            int i = 2 * (x * 480 + y);
+            pixel_table[i] = ix;
+            pixel_table[i+1] = iy;
+            subpixel_table[i] = v;
+            subpixel_table[i+1] = u;
+            num_valid += 1;
+        }
+    }
+}
+
+} // namespace dvs
+} // namespace roboflex
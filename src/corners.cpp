@@ -0,0 +1,163 @@
+#include <algorithm>
+#include "roboflex_dvs/corners.h"
+
+namespace roboflex {
+namespace dvs {
+
+
+// -- DVSCornerData --
+
+DVSCornerData::DVSCornerData(
+    const unsigned short *corner_data, int num_corners,
+    double t, double t0, double t1):
+        core::Message(ModuleName, MessageName)
+{
+    DVSEigenData::DVSFrame corners = Eigen::Map<const Eigen::Matrix<unsigned short, Eigen::Dynamic, 2, Eigen::RowMajor>>(corner_data, num_corners, 2);
+
+    flexbuffers::Builder fbb = get_builder();
+    WriteMapRoot(fbb, [&]() {
+        fbb.Double("t", t);
+        fbb.Double("t0", t0);
+        fbb.Double("t1", t1);
+        serialization::serialize_eigen_matrix(fbb, corners, "corners");
+    });
+}
+
+void DVSCornerData::print_on(ostream& os) const {
+    os << "<DVSCornerData"
+       << " times: (" << get_t0() << " - " << get_t1() << ")"
+       << " t:" << get_t()
+       << " corners: " << get_corners().rows() << " ";
+    Message::print_on(os);
+    os << ">";
+}
+
+
+// -- DVSCornerDetector --
+
+// The two bresenham circles of the eFAST detector, in order around the circle.
+static const int CIRCLE3[16][2] = {
+    {0, 3}, {1, 3}, {2, 2}, {3, 1}, {3, 0}, {3, -1}, {2, -2}, {1, -3},
+    {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3, 1}, {-2, 2}, {-1, 3}};
+
+static const int CIRCLE4[20][2] = {
+    {0, 4}, {1, 4}, {2, 3}, {3, 2}, {4, 1}, {4, 0}, {4, -1}, {3, -2}, {2, -3}, {1, -4},
+    {0, -4}, {-1, -4}, {-2, -3}, {-3, -2}, {-4, -1}, {-4, 0}, {-4, 1}, {-3, 2}, {-2, 3}, {-1, 4}};
+
+// Events closer than this to the border have an incomplete outer circle.
+static const int BORDER = 4;
+
+DVSCornerDetector::DVSCornerDetector(
+    double refractory_period,
+    const std::string& name):
+        core::Node(name),
+        refractory_period(refractory_period),
+        sae_on(SurfaceOfActiveEvents::Zero(320, 480)),
+        sae_off(SurfaceOfActiveEvents::Zero(320, 480))
+{
+
+}
+
+bool DVSCornerDetector::has_streak(
+    const SurfaceOfActiveEvents& sae,
+    int x, int y,
+    const int circle[][2], int circle_size,
+    int min_streak, int max_streak) const
+{
+    // Gather the circle once; everything below works on this copy.
+    double ts[20];
+    for (int i=0; i<circle_size; i++) {
+        ts[i] = sae(x + circle[i][0], y + circle[i][1]);
+    }
+
+    for (int i=0; i<circle_size; i++) {
+        for (int streak_size=min_streak; streak_size<=max_streak; streak_size++) {
+
+            // The streak must be newer than both of its neighbors.
+            if (ts[i] < ts[(i-1+circle_size) % circle_size]) {
+                continue;
+            }
+            if (ts[(i+streak_size-1) % circle_size] < ts[(i+streak_size) % circle_size]) {
+                continue;
+            }
+
+            double min_t = ts[i];
+            for (int j=1; j<streak_size; j++) {
+                min_t = std::min(min_t, ts[(i+j) % circle_size]);
+            }
+
+            // ...and every pixel outside the streak must be older than all of it.
+            bool is_streak = true;
+            for (int j=streak_size; j<circle_size; j++) {
+                if (ts[(i+j) % circle_size] >= min_t) {
+                    is_streak = false;
+                    break;
+                }
+            }
+
+            if (is_streak) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool DVSCornerDetector::process_event(bool polarity, int x, int y, double t)
+{
+    SurfaceOfActiveEvents& sae = polarity ? sae_on : sae_off;
+    const SurfaceOfActiveEvents& sae_other = polarity ? sae_off : sae_on;
+
+    // Only the first event of a burst at one pixel makes it into the SAE.
+    double prev_t = sae(x, y);
+    if (prev_t != 0 && t - prev_t < refractory_period && sae_other(x, y) < prev_t) {
+        return false;
+    }
+
+    sae(x, y) = t;
+
+    if (x < BORDER || x >= 320 - BORDER || y < BORDER || y >= 480 - BORDER) {
+        return false;
+    }
+
+    return has_streak(sae, x, y, CIRCLE3, 16, 3, 6) &&
+           has_streak(sae, x, y, CIRCLE4, 20, 4, 8);
+}
+
+void DVSCornerDetector::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    const DVSEigenData::DVSFrame on_events = input.get_on_events();
+    const DVSEigenData::DVSFrame off_events = input.get_off_events();
+    const double t = input.get_t();
+
+    current_corners.clear();
+
+    for (int i=0; i<on_events.rows(); i++) {
+        if (process_event(true, on_events(i, 0), on_events(i, 1), t)) {
+            current_corners.push_back(on_events(i, 0));
+            current_corners.push_back(on_events(i, 1));
+        }
+    }
+
+    for (int i=0; i<off_events.rows(); i++) {
+        if (process_event(false, off_events(i, 0), off_events(i, 1), t)) {
+            current_corners.push_back(off_events(i, 0));
+            current_corners.push_back(off_events(i, 1));
+        }
+    }
+
+    num_events += on_events.rows() + off_events.rows();
+
+    if (!current_corners.empty()) {
+        int n = current_corners.size() / 2;
+        num_corners += n;
+        this->signal(std::make_shared<DVSCornerData>(
+            current_corners.data(), n, t, input.get_t0(), input.get_t1()));
+    }
+}
+
+} // namespace dvs
+} // namespace roboflex
@@ -1,4 +1,8 @@
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
 #include "roboflex_dvs/dvs.h"
 #include "roboflex_core/util/utils.h"
 
@@ -8,13 +12,14 @@ namespace dvs {
 
 // --- DVSRawData ---
 
-DVSRawData::DVSRawData(double t0, double t1, const uint8_t *byte_data, int num_bytes):
+DVSRawData::DVSRawData(double t0, double t1, const uint8_t *byte_data, int num_bytes, uint64_t transfer_id):
     core::Message(ModuleName, MessageName)
 {
     flexbuffers::Builder fbb = get_builder();
     WriteMapRoot(fbb, [&]() {
         fbb.Double("t0", t0);
         fbb.Double("t1", t1);
+        fbb.UInt("transfer_id", transfer_id);
         fbb.Key("data");
         fbb.Blob(byte_data, num_bytes);
     });
@@ -24,6 +29,7 @@ void DVSRawData::print_on(ostream& os) const {
     os << "<DVSRawData"
        << " t0: " << get_t0()
        << " t1: " << get_t1()
+       << " transfer: " << get_transfer_id()
        << " bytes: " << get_length()
        << " \"" << (int)get_data()[0] << " " << (int)get_data()[1] << " " << (int)get_data()[2] << " ...\" ";
     Message::print_on(os);
@@ -31,34 +37,170 @@ void DVSRawData::print_on(ostream& os) const {
 }
 
 
+// --- DVSRawPacket ---
+
+DVSRawPacket::DVSRawPacket(double t0, double t1, const uint8_t *byte_data, int num_bytes, const DVSDecoderState& state, uint64_t transfer_id):
+    core::Message(ModuleName, MessageName)
+{
+    flexbuffers::Builder fbb = get_builder();
+    WriteMapRoot(fbb, [&]() {
+        fbb.Double("t0", t0);
+        fbb.Double("t1", t1);
+        fbb.UInt("transfer_id", transfer_id);
+        fbb.UInt("long_ts", state.longTs);
+        fbb.UInt("short_ts", state.shortTs);
+        fbb.Int("column", state.posX);
+        fbb.Key("data");
+        fbb.Blob(byte_data, num_bytes);
+    });
+}
+
+DVSDecoderState DVSRawPacket::get_decoder_state() const
+{
+    DVSDecoderState state;
+    state.longTs = root_val("long_ts").AsUInt32();
+    state.shortTs = root_val("short_ts").AsUInt32();
+    state.timeStamp = state.longTs + state.shortTs;
+    state.posX = root_val("column").AsInt32();
+    return state;
+}
+
+std::shared_ptr<DVSRawPacket> DVSRawPacket::from_message(core::MessagePtr m)
+{
+    auto packet = std::dynamic_pointer_cast<DVSRawPacket>(m);
+    return packet != nullptr ? packet : std::make_shared<DVSRawPacket>(*m);
+}
+
+const DVSRawPacket::DVSEventList& DVSRawPacket::get_events() const
+{
+    std::call_once(decode_once, [this]() {
+        std::vector<unsigned int> decoded_events;
+        DVSDecoder decoder;
+        decoder.reset(get_decoder_state());
+        decoder.decode(get_data(), get_length(), [&](bool pol, int x, int y, unsigned int t) {
+            decoded_events.push_back(t);
+            decoded_events.push_back(x);
+            decoded_events.push_back(y);
+            decoded_events.push_back(pol ? 1 : 0);
+        });
+        events = Eigen::Map<const DVSEventList>(decoded_events.data(), decoded_events.size() / 4, 4);
+        decoder_stats = decoder.get_stats();
+        decoded = true;
+    });
+    return events;
+}
+
+const DVSDecoderStats& DVSRawPacket::get_decoder_stats() const
+{
+    get_events();
+    return decoder_stats;
+}
+
+void DVSRawPacket::print_on(ostream& os) const {
+    os << "<DVSRawPacket"
+       << " t0: " << get_t0()
+       << " t1: " << get_t1()
+       << " transfer: " << get_transfer_id()
+       << " bytes: " << get_length()
+       << " long_ts: " << root_val("long_ts").AsUInt32()
+       << " short_ts: " << root_val("short_ts").AsUInt32()
+       << " column: " << root_val("column").AsInt32() << " ";
+    Message::print_on(os);
+    os << ">";
+}
+
+
 // -- DVSEigenData --
 
 DVSEigenData::DVSEigenData(
     unsigned short *on_event_data, int num_on_events,
     unsigned short *off_event_data, int num_off_events,
-    double t, double t0, double t1):
+    double t, double t0, double t1,
+    const DVSBatchMetadata& metadata,
+    const float *on_subpixel_data,
+    const float *off_subpixel_data,
+    const unsigned int *interleaved_data):
         core::Message(ModuleName, MessageName)
 {
     // NOTE! RowMajor might NOT be what you want!!!
     DVSFrame on_events = Eigen::Map<const Eigen::Matrix<unsigned short, Eigen::Dynamic, 2, Eigen::RowMajor>>(on_event_data, num_on_events, 2);
     DVSFrame off_events = Eigen::Map<const Eigen::Matrix<unsigned short, Eigen::Dynamic, 2, Eigen::RowMajor>>(off_event_data, num_off_events, 2);
 
+    bool with_subpixel = on_subpixel_data != nullptr || off_subpixel_data != nullptr;
+    DVSSubpixelFrame on_subpixel, off_subpixel;
+    if (with_subpixel) {
+        on_subpixel = Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, 2, Eigen::RowMajor>>(on_subpixel_data, num_on_events, 2);
+        off_subpixel = Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, 2, Eigen::RowMajor>>(off_subpixel_data, num_off_events, 2);
+    }
+
+    DVSInterleavedFrame interleaved_events;
+    if (interleaved_data != nullptr) {
+        interleaved_events = Eigen::Map<const Eigen::Matrix<unsigned int, Eigen::Dynamic, 4, Eigen::RowMajor>>(interleaved_data, num_on_events + num_off_events, 4);
+    }
+
     flexbuffers::Builder fbb = get_builder();
     WriteMapRoot(fbb, [&]() {
         fbb.Double("t", t);
         fbb.Double("t0", t0);
         fbb.Double("t1", t1);
+        fbb.UInt("transfer_id", metadata.transfer_id);
+        fbb.Double("transfer_t1", metadata.transfer_t1);
+        fbb.UInt("t_first", metadata.t_first);
+        fbb.UInt("t_last", metadata.t_last);
+        fbb.UInt("dropped_events", metadata.dropped_events);
+        fbb.UInt("dropped_bytes", metadata.dropped_bytes);
+        fbb.Int("num_on", num_on_events);
+        fbb.Int("num_off", num_off_events);
         serialization::serialize_eigen_matrix(fbb, on_events, "on_events");
         serialization::serialize_eigen_matrix(fbb, off_events, "off_events");
+        if (with_subpixel) {
+            serialization::serialize_eigen_matrix(fbb, on_subpixel, "on_subpixel");
+            serialization::serialize_eigen_matrix(fbb, off_subpixel, "off_subpixel");
+        }
+        if (interleaved_data != nullptr) {
+            serialization::serialize_eigen_matrix(fbb, interleaved_events, "events");
+        }
     });
 }
 
+DVSBatchMetadata DVSEigenData::get_metadata() const
+{
+    DVSBatchMetadata metadata;
+    metadata.transfer_id = get_transfer_id();
+    metadata.transfer_t1 = root_val("transfer_t1").AsDouble();
+    metadata.dropped_events = root_val("dropped_events").AsUInt64();
+    metadata.dropped_bytes = root_val("dropped_bytes").AsUInt64();
+    if (root_val("t_first").IsNull()) {
+        metadata.t_first = metadata.t_last = get_t();
+    } else {
+        metadata.t_first = root_val("t_first").AsUInt32();
+        metadata.t_last = root_val("t_last").AsUInt32();
+    }
+    return metadata;
+}
+
+int DVSEigenData::get_num_on_events() const
+{
+    auto num_on = root_val("num_on");
+    return num_on.IsNull() ? get_on_events().rows() : num_on.AsInt32();
+}
+
+int DVSEigenData::get_num_off_events() const
+{
+    auto num_off = root_val("num_off");
+    return num_off.IsNull() ? get_off_events().rows() : num_off.AsInt32();
+}
+
 void DVSEigenData::print_on(ostream& os) const {
     os << "<DVSEigenData"
        << " times: (" << get_t0() << " - " << get_t1() << ")"
        << " t:" << get_t()
+       << " transfer: " << get_transfer_id()
        << " on_events: (" << get_on_events().rows() << ", " << get_on_events().cols() << ")"
-       << " off_events: (" << get_off_events().rows() << ", " << get_off_events().cols() << ") ";
+       << " off_events: (" << get_off_events().rows() << ", " << get_off_events().cols() << ")"
+       << " dropped: " << get_metadata().dropped_events << " "
+       << (has_subpixel() ? "subpixel " : "")
+       << (has_interleaved() ? "interleaved " : "");
     Message::print_on(os);
     os << ">";
 }
@@ -85,10 +227,20 @@ void DVSEigenImage::print_on(ostream& os) const {
 
 // --- DVSSensor ---
 
-DVSSensor::DVSSensor(const std::string &name):
-    core::RunnableNode(name),
-    dvs_handle_(nullptr)
+DVSSensor::DVSSensor(
+    const std::string &name,
+    int transfer_size,
+    const DVSThreadOptions& thread_options):
+        core::RunnableNode(name),
+        dvs_handle_(nullptr),
+        transfer_size(transfer_size),
+        thread_options(thread_options)
 {
+    if (transfer_size <= 0) {
+        throw std::runtime_error("DVSSensor: transfer_size must be positive");
+    }
+    validate_thread_options(thread_options);
+
     // std::string script = "./build/third_party/dvs_semiconductor_code/dvsconf -l ./third_party/dvs_semiconductor_code/dvs_configurations/run_dvs_gen3.txt";
     // int dvs_initialized = system(script.c_str());
     // if (dvs_initialized != 0) {
@@ -138,14 +290,55 @@ DVSSensor::~DVSSensor()
     cyusb_close();
 }
 
+static int register_value_length(int slave_address)
+{
+    // The DVS (0x20, 0x30) and FX3 (0x40) slaves have one-byte registers.
+    return (slave_address == 0x1A || slave_address == 0x1C) ? 2 : 1;
+}
+
+int DVSSensor::read_register(int slave_address, int address)
+{
+    const int CONTROL_TIMEOUT = 1000;
+    int length = register_value_length(slave_address);
+    unsigned char buf[2];
+
+    int r = libusb_control_transfer(this->dvs_handle_, 0xC0, 0xBB, slave_address, address, buf, length, CONTROL_TIMEOUT);
+    if (r != length) {
+        return -1;
+    }
+    return length == 1 ? buf[0] : (buf[0] << 8) + buf[1];
+}
+
+bool DVSSensor::write_register(int slave_address, int address, int value)
+{
+    const int CONTROL_TIMEOUT = 1000;
+    int length = register_value_length(slave_address);
+    unsigned char buf[2];
+
+    if (length == 1) {
+        buf[0] = value & 0xFF;
+    } else {
+        buf[0] = (value >> 8) & 0xFF;
+        buf[1] = value & 0xFF;
+    }
+
+    int r = libusb_control_transfer(this->dvs_handle_, 0x40, 0xBA, slave_address, address, buf, length, CONTROL_TIMEOUT);
+    return r == length;
+}
+
 void DVSSensor::child_thread_fn()
 {
-    const int MAX_BUFFER_SIZE = 1024;
     const int BULK_TIMEOUT = 1000;
 
-    uint8_t buffer[MAX_BUFFER_SIZE];
+    std::vector<uint8_t> buffer(transfer_size);
     int num_bytes_read;
 
+    // The encoder (and anything else downstream) runs on this thread
+    // too, so these settings cover decoding as well.
+    apply_thread_options(thread_options, get_name());
+
+    double prev_t1 = 0;
+
     while (!this->stop_signal) {
         double t0 = core::get_current_time();
 
@@ -153,8 +346,8 @@ void DVSSensor::child_thread_fn()
         int r = libusb_bulk_transfer(
             this->dvs_handle_,
             0x81,
-            buffer,
-            MAX_BUFFER_SIZE,
+            buffer.data(),
+            transfer_size,
             &num_bytes_read,
             BULK_TIMEOUT);
 
@@ -172,13 +365,52 @@ void DVSSensor::child_thread_fn()
             // Take another time measurement.
             double t1 = core::get_current_time();
 
+            num_transfers += 1;
+            trace_span("transfer", num_transfers, t0, t1);
+
+            // How regularly do transfers complete?
+            if (prev_t1 > 0) {
+                jitter_histogram.record(t1 - prev_t1);
+            }
+            prev_t1 = t1;
+
             // signal the data downstream.
-            this->signal(std::make_shared<DVSRawData>(t0, t1, buffer, num_bytes_read));
+            this->signal(raw_data_pool.make(t0, t1, buffer.data(), num_bytes_read, num_transfers));
         }
     }
 }
 
 
+// -- DVSRawPacketizer --
+
+DVSRawPacketizer::DVSRawPacketizer(const std::string& name):
+    core::Node(name)
+{
+
+}
+
+void DVSRawPacketizer::receive(core::MessagePtr m)
+{
+    DVSRawData b(*m);
+
+    if (b.get_data() == nullptr || b.get_length() <= 0) {
+        return;
+    }
+
+    // Packets hold whole words only; a partial word waits for the next transfer.
+    aligned_bytes.insert(aligned_bytes.end(), b.get_data(), b.get_data() + b.get_length());
+    int num_whole = (aligned_bytes.size() / 4) * 4;
+
+    if (num_whole > 0) {
+        auto packet = raw_packet_pool.make(b.get_t0(), b.get_t1(), aligned_bytes.data(), num_whole, decoder_state, b.get_transfer_id());
+        track_gen3_state(aligned_bytes.data(), num_whole, decoder_state);
+        this->signal(packet);
+    }
+
+    aligned_bytes.erase(aligned_bytes.begin(), aligned_bytes.begin() + num_whole);
+}
+
+
 // -- DVSEncoder --
 
 DVSEncoder::DVSEncoder(const std::string& name):
@@ -189,35 +421,110 @@ DVSEncoder::DVSEncoder(const std::string& name):
 
 }
 
+void DVSEncoder::set_undistortion(std::shared_ptr<const DVSUndistortionTable> table, bool subpixel)
+{
+    this->undistortion = table;
+    this->subpixel = table != nullptr && subpixel;
+    current_on_subpixel.resize(this->subpixel ? 640*480*2 : 0);
+    current_off_subpixel.resize(this->subpixel ? 640*480*2 : 0);
+}
+
+void DVSEncoder::set_interleaved(bool interleaved)
+{
+    this->interleaved = interleaved;
+    current_interleaved.resize(interleaved ? 640*480*2*4 : 0);
+}
+
+// One timestamp adds at most one event per pixel and polarity, and
+// the frame buffers hold twice that, so a frame with no more than this
+// many events of either polarity has room for another timestamp.
+static const unsigned int MAX_EVENTS_BEFORE_TIMESTAMP = 320 * 480;
+
 void DVSEncoder::got_event(bool on_off, int x, int y, unsigned int t)
 {
     if (prev_time_stamp == 0) {
         this->t0 = core::get_current_time();
+        frame_transfer_id = decoding_transfer_id;
+        frame_transfer_t1 = decoding_transfer_t1;
         prev_time_stamp = t;
+        frame_t_first = t;
         current_on_event_index = 0;
         current_off_event_index = 0;
     }
 
-    if (t != prev_time_stamp) {
+    // We've come to a new timestamp: send the frame, unless it's
+    // to go on collecting timestamps for the batch duration. Time that
+    // goes backwards always starts a new one.
+    bool frame_done = t != prev_time_stamp && (
+        t < prev_time_stamp ||
+        t - frame_t_first >= batch_duration ||
+        current_on_event_index > MAX_EVENTS_BEFORE_TIMESTAMP ||
+        current_off_event_index > MAX_EVENTS_BEFORE_TIMESTAMP);
 
-        // We've come to a new timestamp, so send the previous frame
+    if (frame_done) {
 
         if (current_on_event_index > 0 || current_off_event_index > 0) {
             double t1 = core::get_current_time();
 
-            this->signal(std::make_shared<DVSEigenData>(
+            DVSBatchMetadata metadata;
+            metadata.t_first = frame_t_first;
+            metadata.t_last = prev_time_stamp;
+            metadata.transfer_id = frame_transfer_id;
+            metadata.transfer_t1 = frame_transfer_t1;
+            metadata.dropped_events = num_undistortion_dropped;
+            DVSDecoderStats decoder_stats = get_decoder_stats();
+            metadata.dropped_bytes = decoder_stats.bytes_discarded + 4 * decoder_stats.invalid_words;
+
+            auto frame = eigen_data_pool.make(
                 current_on_events, current_on_event_index,
                 current_off_events, current_off_event_index,
-                prev_time_stamp, this->t0, t1));
+                prev_time_stamp, this->t0, t1,
+                metadata,
+                subpixel ? current_on_subpixel.data() : nullptr,
+                subpixel ? current_off_subpixel.data() : nullptr,
+                interleaved ? current_interleaved.data() : nullptr);
+            trace_span("build", frame_transfer_id, t1, core::get_current_time());
+
+            this->signal(frame);
         }
 
         this->t0 = core::get_current_time();
+        frame_transfer_id = decoding_transfer_id;
+        frame_transfer_t1 = decoding_transfer_t1;
 
-        prev_time_stamp = t;
+        frame_t_first = t;
         current_on_event_index = 0;
         current_off_event_index = 0;
     }
 
+    prev_time_stamp = t;
+
+    if (undistortion) {
+        unsigned short ux, uy;
+        if (x < 0 || x >= 320 || y < 0 || y >= 480 || !undistortion->lookup(x, y, ux, uy)) {
+            num_undistortion_dropped += 1;
+            return;
+        }
+        if (subpixel) {
+            float sx, sy;
+            undistortion->lookup_subpixel(x, y, sx, sy);
+            std::vector<float>& current_subpixel = on_off ? current_on_subpixel : current_off_subpixel;
+            unsigned int index = on_off ? current_on_event_index : current_off_event_index;
+            current_subpixel[2*index] = sx;
+            current_subpixel[2*index+1] = sy;
+        }
+        x = ux;
+        y = uy;
+    }
+
+    if (interleaved) {
+        unsigned int index = current_on_event_index + current_off_event_index;
+        current_interleaved[4*index] = x;
+        current_interleaved[4*index+1] = y;
+        current_interleaved[4*index+2] = on_off ? 1 : 0;
+        current_interleaved[4*index+3] = t;
+    }
+
     if (on_off) {
         current_on_events[2*current_on_event_index] = x;
         current_on_events[2*current_on_event_index+1] = y;
@@ -231,85 +538,83 @@ void DVSEncoder::got_event(bool on_off, int x, int y, unsigned int t)
 
 void DVSEncoder::receive(core::MessagePtr m) 
 {
+    auto on_event = [this](bool pol, int x, int y, unsigned int t) {
+        got_event(pol, x, y, t);
+    };
+
+    if (m->message_name() == DVSRawPacket::MessageName) {
+
+        // Packets carry the decoder state they start with, so each one
+        // decodes on its own, even if some were lost on the way; and
+        // they cache what they decode to, for any other consumers.
+        auto p = DVSRawPacket::from_message(m);
+        if (p->get_data() != nullptr && p->get_length() > 0) {
+            double t_begin = is_tracing_enabled() ? core::get_current_time() : 0;
+            decoding_transfer_id = p->get_transfer_id();
+            decoding_transfer_t1 = p->get_t1();
+            const DVSRawPacket::DVSEventList& events = p->get_events();
+            packet_decoder_stats += p->get_decoder_stats();
+            for (int i=0; i<events.rows(); i++) {
+                got_event(events(i, 3) != 0, events(i, 1), events(i, 2), events(i, 0));
+            }
+            trace_span("decode", decoding_transfer_id, t_begin, core::get_current_time());
+        }
+        return;
+    }
+
     DVSRawData b(*m);
 
-    int grpAddr = 0;
-    int posY0 = 0;
-    int posY = 0;
-    int posX = 0;
-    bool pol = false;
+    if (b.get_data() != nullptr && b.get_length() > 0) {
+        double t_begin = is_tracing_enabled() ? core::get_current_time() : 0;
+        decoding_transfer_id = b.get_transfer_id();
+        decoding_transfer_t1 = b.get_t1();
+        decoder.decode(b.get_data(), b.get_length(), on_event);
+        trace_span("decode", decoding_transfer_id, t_begin, core::get_current_time());
+    }
+}
 
-    //int packetID = 0;
 
-    if (b.get_data() != nullptr && b.get_length() > 0) {
+DVSDecoderStats DVSEncoder::get_decoder_stats() const
+{
+    DVSDecoderStats stats = decoder.get_stats();
+    stats += packet_decoder_stats;
+    return stats;
+}
 
-        unsigned char *buf = (unsigned char *)(b.get_data());
-        int transferred = b.get_length();
-
-		if (transferred % 4) transferred = (transferred / 4) * 4;
-
-		for(int i=0; i<transferred; i+=4) {
-
-			int header = buf[i] & 0x7C;
-			//id = buf[i] & 0x03;
-
-			if (buf[i] & 0x80) {	// Group Packet
-
-				grpAddr = (buf[i+1] & 0xFC) >> 2;
-
-				if (buf[i + 3]) {
-					posY0 = grpAddr << 3;
-					pol = (buf[i+1] & 0x01) ? true : false;
-					for (int n=0; n<8; n++) {
-						if ((buf[i+3] >> n) & 0x01) {
-							posY = posY0 + n;
-                            got_event(pol, posX, 479-posY, timeStamp);
-						}
-					}
-				}
-
-				if (buf[i + 2]) {
-					grpAddr += (header >> 2);	// Offset
-					posY0 = grpAddr << 3;
-					pol = (buf[i+1] & 0x02) ? true : false;
-					for (int n=0; n<8; n++) {
-						if ((buf[i+2] >> n) & 0x01) {
-							posY = posY0 + n;
-                            got_event(pol, posX, 479-posY, timeStamp);
- 						}
-					}
-				}
-
-			} else {					// Normal Packet
-
-				switch (header) {
-					case (0x04) :	// 0000 01** | --ST TTTT | TTTT T-CC | CCCC CCCC	Column Address (10) + SubTimestamp (10)
-						shortTs = ((buf[i+1] & 0x1F) << 5) | ((buf[i+2] & 0xF8) >> 3);
-						timeStamp = longTs + shortTs;
-						//posX = (((buf[i + 2] & 0x03) << 8) | (buf[i + 3] & 0xFF));		// Original
-						posX = 319 - (((buf[i + 2] & 0x03) << 8) | (buf[i + 3] & 0xFF));		// Rotation
-						break;
-
-					case (0x08) :	// 0000 01** | --TT TTTT | TTTT TTTT | TTTT TTTT	Reference Timestamp (22)
-						longTs = (((buf[i + 1] & 0x3F) << 16) | ((buf[i + 2] & 0xFF) << 8) | (buf[i + 3] & 0xFF)) * 1000;
-						timeStamp = longTs + shortTs; // ?
-                        break;
-
-					case (0x40) :	// 0100 00** | --II IIII | IIII IIII | IIII IIII	Packet ID (22)
-						// Packet ID is used to check packet loss
-						//packetID = ((buf[i + 1] & 0x3F) << 26) | ((buf[i + 2] & 0xFF) << 18) | ((buf[i + 3] & 0xFF) << 10);
-                        //std::cout << "packetid:" << packetID << std::endl;
-						break;
-
-					case (0x00) :	// 0000 0000 | 0000 0000 | 0000 0000 | 0000 0000	Padding
-						//i = dataLen;	// ignore all the remaining packet data
-						break;
-
-					default :		// This should not happen
-						break;
-				}
-			}
-        }
+
+// -- DVSPeriodicNode --
+
+DVSPeriodicNode::DVSPeriodicNode(
+    float emit_frequency_hz,
+    double event_period,
+    const std::string &name):
+        nodes::FrequencyGenerator(emit_frequency_hz, name),
+        event_period(event_period)
+{
+
+}
+
+void DVSPeriodicNode::on_trigger(double wall_clock_time)
+{
+    if (!is_event_time_driven()) {
+        emit(wall_clock_time);
+    }
+}
+
+void DVSPeriodicNode::advance_event_time(double t)
+{
+    if (!is_event_time_driven()) {
+        return;
+    }
+
+    if (next_emit_t < 0 || t < next_emit_t - event_period) {
+        next_emit_t = (std::floor(t / event_period) + 1) * event_period;
+        return;
+    }
+
+    if (t >= next_emit_t) {
+        emit(next_emit_t);
+        next_emit_t = (std::floor(t / event_period) + 1) * event_period;
     }
 }
 
@@ -318,37 +623,219 @@ void DVSEncoder::receive(core::MessagePtr m)
 
 DVSEigenToGrayScale::DVSEigenToGrayScale(
     float emit_frequency_hz,
-    const std::string &name):
-        nodes::FrequencyGenerator(emit_frequency_hz, name)
+    const std::string &name,
+    GrayScaleNormalization normalization,
+    int event_weight,
+    int parallel_threshold,
+    int num_threads,
+    double event_period):
+        DVSPeriodicNode(emit_frequency_hz, event_period, name),
         //, accumulated_image(xt::ones<uint8_t>({320, 480}))
+        normalization(normalization),
+        event_weight(event_weight),
+        parallel_threshold(parallel_threshold),
+        num_threads(std::max(1, num_threads)),
+        count_image(CountImage::Zero(320, 480))
 {
     accumulated_image.fill(128);
+
+    if (this->num_threads > 1) {
+        partial_counts.assign(this->num_threads, PartialCountImage::Zero(320, 480));
+    }
+}
+
+DVSEigenToGrayScale::~DVSEigenToGrayScale()
+{
+    {
+        const std::lock_guard<std::mutex> lock(workers_mutex);
+        workers_stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+void DVSEigenToGrayScale::worker_thread_fn(int k)
+{
+    uint64_t generation = 0;
+    while (true) {
+        std::function<void(int)> job;
+        {
+            std::unique_lock<std::mutex> lock(workers_mutex);
+            work_ready.wait(lock, [&]() { return workers_stopping || work_generation != generation; });
+            if (workers_stopping) {
+                return;
+            }
+            generation = work_generation;
+            job = work_job;
+        }
+
+        job(k);
+
+        const std::lock_guard<std::mutex> lock(workers_mutex);
+        if (--workers_busy == 0) {
+            work_done.notify_one();
+        }
+    }
+}
+
+void DVSEigenToGrayScale::run_on_workers(const std::function<void(int)>& job)
+{
+    if (workers.empty()) {
+        for (int k=1; k<num_threads; k++) {
+            workers.emplace_back(&DVSEigenToGrayScale::worker_thread_fn, this, k);
+        }
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(workers_mutex);
+        work_job = job;
+        workers_busy = num_threads - 1;
+        work_generation += 1;
+    }
+    work_ready.notify_all();
+
+    job(0);
+
+    std::unique_lock<std::mutex> lock(workers_mutex);
+    work_done.wait(lock, [&]() { return workers_busy == 0; });
+}
+
+static inline void saturating_increment(int16_t& c)
+{
+    if (c < std::numeric_limits<int16_t>::max()) c += 1;
+}
+
+static inline void saturating_decrement(int16_t& c)
+{
+    if (c > std::numeric_limits<int16_t>::min()) c -= 1;
+}
+
+void DVSEigenToGrayScale::accumulate(
+    const DVSEigenData::DVSFrame& on_events,
+    const DVSEigenData::DVSFrame& off_events)
+{
+    int16_t* counts = count_image.data();
+
+    // The frames are column-major: all the xs, then all the ys.
+    const unsigned short* on_x = on_events.col(0).data();
+    const unsigned short* on_y = on_events.col(1).data();
+    for (int i=0; i<on_events.rows(); i++) {
+        saturating_increment(counts[on_x[i] * 480 + on_y[i]]);
+    }
+
+    const unsigned short* off_x = off_events.col(0).data();
+    const unsigned short* off_y = off_events.col(1).data();
+    for (int i=0; i<off_events.rows(); i++) {
+        saturating_decrement(counts[off_x[i] * 480 + off_y[i]]);
+    }
+}
+
+void DVSEigenToGrayScale::accumulate_parallel(
+    const DVSEigenData::DVSFrame& on_events,
+    const DVSEigenData::DVSFrame& off_events)
+{
+    // The partials are all zero between batches.
+    run_on_workers([&](int k) {
+        int32_t* counts = partial_counts[k].data();
+
+        int on_begin = on_events.rows() * k / num_threads;
+        int on_end = on_events.rows() * (k + 1) / num_threads;
+        for (int i=on_begin; i<on_end; i++) {
+            counts[on_events(i, 0) * 480 + on_events(i, 1)] += 1;
+        }
+
+        int off_begin = off_events.rows() * k / num_threads;
+        int off_end = off_events.rows() * (k + 1) / num_threads;
+        for (int i=off_begin; i<off_end; i++) {
+            counts[off_events(i, 0) * 480 + off_events(i, 1)] -= 1;
+        }
+    });
+
+    // Reduce a band of rows per thread, saturate once at the end, and
+    // leave the band zeroed while it's still in cache.
+    const std::lock_guard<std::mutex> lock(image_mutex);
+    run_on_workers([&](int k) {
+        int row_begin = 320 * k / num_threads;
+        int num_rows = 320 * (k + 1) / num_threads - row_begin;
+
+        auto total = partial_counts[0].middleRows(row_begin, num_rows);
+        for (int j=1; j<num_threads; j++) {
+            auto partial = partial_counts[j].middleRows(row_begin, num_rows);
+            total += partial;
+            partial.setZero();
+        }
+
+        count_image.middleRows(row_begin, num_rows) = (count_image.middleRows(row_begin, num_rows).cast<int32_t>() + total)
+            .cwiseMax(std::numeric_limits<int16_t>::min())
+            .cwiseMin(std::numeric_limits<int16_t>::max())
+            .cast<int16_t>();
+        total.setZero();
+    });
 }
 
 void DVSEigenToGrayScale::receive(core::MessagePtr m)
 {
     DVSEigenData input(*m);
+    double t_begin = is_tracing_enabled() ? core::get_current_time() : 0;
+
+    // Emits what we have so far, if this batch starts a new period.
+    advance_event_time(input.get_t());
 
     const DVSEigenData::DVSFrame& on_events(input.get_on_events());
     const DVSEigenData::DVSFrame& off_events(input.get_off_events());
 
-    const std::lock_guard<std::mutex> lock(image_mutex);
-
-    for (int i=0; i<on_events.rows(); i++) {
-        accumulated_image(on_events(i, 0), on_events(i, 1)) += 40;
+    if (num_threads > 1 && on_events.rows() + off_events.rows() >= parallel_threshold) {
+        accumulate_parallel(on_events, off_events);
+    } else {
+        const std::lock_guard<std::mutex> lock(image_mutex);
+        accumulate(on_events, off_events);
     }
 
-    for (int i=0; i<off_events.rows(); i++) {
-        accumulated_image(off_events(i, 0), off_events(i, 1)) -= 40;
+    last_transfer_id = input.get_transfer_id();
+    trace_span("accumulate", last_transfer_id, t_begin, core::get_current_time());
+}
+
+void DVSEigenToGrayScale::normalize_into_image()
+{
+    Eigen::ArrayXXf counts = count_image.cast<float>().array();
+    Eigen::ArrayXXf gray;
+
+    switch (normalization) {
+        case GrayScaleNormalization::MinMax: {
+            float lo = counts.minCoeff();
+            float hi = counts.maxCoeff();
+            if (hi > lo) {
+                gray = (counts - lo) * (255.0f / (hi - lo));
+            } else {
+                gray = Eigen::ArrayXXf::Constant(320, 480, 128.0f);
+            }
+            break;
+        }
+        case GrayScaleNormalization::AbsMax: {
+            float max_abs = counts.abs().maxCoeff();
+            gray = 128.0f + counts * (max_abs > 0 ? 127.0f / max_abs : 0.0f);
+            break;
+        }
+        case GrayScaleNormalization::Fixed:
+        default:
+            gray = 128.0f + counts * (float)event_weight;
+            break;
     }
+
+    accumulated_image = gray.max(0.0f).min(255.0f).cast<uint8_t>().matrix();
 }
 
-void DVSEigenToGrayScale::on_trigger(double wall_clock_time)
+void DVSEigenToGrayScale::emit(double time)
 {
     const std::lock_guard<std::mutex> lock(image_mutex);
+    double t_begin = is_tracing_enabled() ? core::get_current_time() : 0;
+    normalize_into_image();
     //this->signal(std::make_shared<core::TensorMessage<uint8_t, 2>>(accumulated_image, "DVSImage", "image"));
     this->signal(core::EigenMessage<uint8_t, 320, 480, Eigen::RowMajor>::Ptr(accumulated_image, "DVSImage", "image"));
-    accumulated_image.fill(128);
+    count_image.setZero();
+    trace_span("emit", last_transfer_id, t_begin, core::get_current_time());
 }
 
 } // namespace dvs
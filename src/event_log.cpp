@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "roboflex_dvs/event_log.h"
+
+namespace roboflex {
+namespace dvs {
+
+static const char LOG_MAGIC[8] = {'R', 'F', 'D', 'V', 'S', 'L', 'O', 'G'};
+static const char INDEX_MAGIC[8] = {'R', 'F', 'D', 'V', 'S', 'I', 'D', 'X'};
+// 2: frame times are unwrapped log time.
+static const uint32_t LOG_VERSION = 2;
+
+// How far (usec) the host clock may disagree with the sensor clock
+// over a backwards jump for it still to count as a wrap.
+static const double WRAP_TOLERANCE = 1e6;
+
+static const size_t HEADER_SIZE = sizeof(LOG_MAGIC) + 2 * sizeof(uint32_t);
+static const size_t FOOTER_SIZE = 2 * sizeof(uint64_t) + sizeof(INDEX_MAGIC);
+
+// t, t0, t1, num_on, num_off
+static const size_t FRAME_HEADER_SIZE = 3 * sizeof(double) + 2 * sizeof(uint32_t);
+
+template <typename T>
+static void append(std::vector<char>& bytes, const T& value)
+{
+    const char* p = reinterpret_cast<const char*>(&value);
+    bytes.insert(bytes.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static T extract(const char*& p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+
+// -- DVSEventLogWriter --
+
+DVSEventLogWriter::DVSEventLogWriter(
+    const std::string& filename,
+    unsigned int events_per_block,
+    const std::string& name):
+        core::Node(name),
+        filename(filename),
+        events_per_block(events_per_block),
+        file(filename, std::ios::binary | std::ios::trunc)
+{
+    if (!file) {
+        throw std::runtime_error("Unable to open event log for writing: " + filename);
+    }
+
+    uint32_t reserved = 0;
+    file.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+    file.write(reinterpret_cast<const char*>(&LOG_VERSION), sizeof(LOG_VERSION));
+    file.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    check_written();
+}
+
+DVSEventLogWriter::~DVSEventLogWriter()
+{
+    try {
+        close();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void DVSEventLogWriter::check_written()
+{
+    // Give up on the file: a log without its index can't be read anyway.
+    if (!file) {
+        file.close();
+        throw std::runtime_error("Unable to write event log: " + filename);
+    }
+}
+
+void DVSEventLogWriter::flush_block()
+{
+    if (current_block.num_frames == 0) {
+        return;
+    }
+
+    current_block.offset = file.tellp();
+    current_block.num_bytes = block_bytes.size();
+    file.write(block_bytes.data(), block_bytes.size());
+    check_written();
+    index.push_back(current_block);
+
+    block_bytes.clear();
+    current_block = DVSEventLogBlock();
+}
+
+double DVSEventLogWriter::unwrap(double t, double t0)
+{
+    if (last_sensor_t >= 0 && t < last_sensor_t) {
+        double host_elapsed = (t0 - last_t0) * 1e6;
+        double wrapped_elapsed = t + DVSTimestampWrap - last_sensor_t;
+        if (std::abs(wrapped_elapsed - host_elapsed) <= WRAP_TOLERANCE) {
+            time_offset += DVSTimestampWrap;
+            num_wraps += 1;
+        } else {
+            time_offset = last_log_t + std::max(0.0, host_elapsed) - t;
+            num_discontinuities += 1;
+        }
+    }
+
+    last_sensor_t = t;
+    last_t0 = t0;
+    last_log_t = t + time_offset;
+    return last_log_t;
+}
+
+void DVSEventLogWriter::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    const DVSEigenData::DVSFrame on_events = input.get_on_events();
+    const DVSEigenData::DVSFrame off_events = input.get_off_events();
+
+    const std::lock_guard<std::mutex> lock(file_mutex);
+
+    if (!file.is_open()) {
+        return;
+    }
+
+    const double t = unwrap(input.get_t(), input.get_t0());
+
+    if (current_block.num_frames == 0) {
+        current_block.t_begin = t;
+    }
+    current_block.t_end = t;
+    current_block.num_frames += 1;
+    current_block.num_events += on_events.rows() + off_events.rows();
+
+    append(block_bytes, t);
+    append(block_bytes, input.get_t0());
+    append(block_bytes, input.get_t1());
+    append(block_bytes, (uint32_t)on_events.rows());
+    append(block_bytes, (uint32_t)off_events.rows());
+
+    for (const DVSEigenData::DVSFrame* events: {&on_events, &off_events}) {
+        for (int i=0; i<events->rows(); i++) {
+            uint16_t x = (*events)(i, 0);
+            uint16_t y = (*events)(i, 1);
+            append(block_bytes, x);
+            append(block_bytes, y);
+            current_block.x_min = std::min(current_block.x_min, x);
+            current_block.y_min = std::min(current_block.y_min, y);
+            current_block.x_max = std::max(current_block.x_max, x);
+            current_block.y_max = std::max(current_block.y_max, y);
+        }
+    }
+
+    if (current_block.num_events >= events_per_block) {
+        flush_block();
+    }
+}
+
+void DVSEventLogWriter::close()
+{
+    const std::lock_guard<std::mutex> lock(file_mutex);
+
+    if (!file.is_open()) {
+        return;
+    }
+
+    flush_block();
+
+    uint64_t index_offset = file.tellp();
+    uint64_t num_blocks = index.size();
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(DVSEventLogBlock));
+    file.write(reinterpret_cast<const char*>(&index_offset), sizeof(index_offset));
+    file.write(reinterpret_cast<const char*>(&num_blocks), sizeof(num_blocks));
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    check_written();
+
+    // Closing flushes, and that can fail too.
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Unable to write event log: " + filename);
+    }
+}
+
+
+// -- DVSEventLog --
+
+DVSEventLog::DVSEventLog(const std::string& filename):
+    filename(filename),
+    file(filename, std::ios::binary)
+{
+    if (!file) {
+        throw std::runtime_error("Unable to open event log: " + filename);
+    }
+
+    char magic[8];
+    uint32_t version = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not an event log: " + filename);
+    }
+    if (version != LOG_VERSION) {
+        throw std::runtime_error("Unsupported event log version " + std::to_string(version) + ": " + filename);
+    }
+
+    file.seekg(0, std::ios::end);
+    uint64_t file_size = file.tellg();
+
+    uint64_t index_offset, num_blocks;
+    file.seekg(-(std::streamoff)FOOTER_SIZE, std::ios::end);
+    file.read(reinterpret_cast<char*>(&index_offset), sizeof(index_offset));
+    file.read(reinterpret_cast<char*>(&num_blocks), sizeof(num_blocks));
+    file.read(magic, sizeof(magic));
+    if (!file || file_size < HEADER_SIZE + FOOTER_SIZE || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Event log has no index (was the writer closed?): " + filename);
+    }
+
+    // The index sits between the blocks and the footer, exactly.
+    uint64_t index_end = file_size - FOOTER_SIZE;
+    if (index_offset < HEADER_SIZE || index_offset > index_end ||
+        num_blocks != (index_end - index_offset) / sizeof(DVSEventLogBlock) ||
+        (index_end - index_offset) % sizeof(DVSEventLogBlock) != 0) {
+        throw std::runtime_error("Event log index is corrupt: " + filename);
+    }
+
+    index.resize(num_blocks);
+    file.seekg(index_offset);
+    file.read(reinterpret_cast<char*>(index.data()), num_blocks * sizeof(DVSEventLogBlock));
+    if (!file) {
+        throw std::runtime_error("Event log index is truncated: " + filename);
+    }
+
+    // Queries binary search the index, which only works if it's sorted.
+    for (size_t i=0; i<index.size(); i++) {
+        if (index[i].t_end < index[i].t_begin || (i > 0 && index[i].t_begin < index[i-1].t_end)) {
+            throw std::runtime_error("Event log blocks are out of time order: " + filename);
+        }
+        if (index[i].offset < HEADER_SIZE || index[i].offset > index_offset ||
+            index[i].num_bytes > index_offset - index[i].offset) {
+            throw std::runtime_error("Event log index is corrupt: " + filename);
+        }
+    }
+}
+
+double DVSEventLog::get_t_begin() const
+{
+    return index.empty() ? 0.0 : index.front().t_begin;
+}
+
+double DVSEventLog::get_t_end() const
+{
+    return index.empty() ? 0.0 : index.back().t_end;
+}
+
+std::vector<std::shared_ptr<DVSEigenData>> DVSEventLog::query(
+    double t_begin,
+    double t_end,
+    int x_min,
+    int y_min,
+    int x_max,
+    int y_max)
+{
+    std::vector<std::shared_ptr<DVSEigenData>> results;
+    std::vector<unsigned short> on_events;
+    std::vector<unsigned short> off_events;
+
+    // The first block that ends at or after t_begin.
+    auto block = std::partition_point(index.begin(), index.end(),
+        [t_begin](const DVSEventLogBlock& b) { return b.t_end < t_begin; });
+
+    for (; block != index.end() && block->t_begin <= t_end; ++block) {
+
+        if (block->x_max < x_min || block->x_min > x_max ||
+            block->y_max < y_min || block->y_min > y_max) {
+            continue;
+        }
+
+        block_bytes.resize(block->num_bytes);
+        file.seekg(block->offset);
+        file.read(block_bytes.data(), block->num_bytes);
+        if (!file) {
+            throw std::runtime_error("Event log block is truncated: " + filename);
+        }
+
+        // Every frame has to fit in what's left of the block.
+        const char* p = block_bytes.data();
+        const char* end = p + block->num_bytes;
+        for (uint32_t f=0; f<block->num_frames; f++) {
+            if ((size_t)(end - p) < FRAME_HEADER_SIZE) {
+                throw std::runtime_error("Event log block is corrupt: " + filename);
+            }
+            double t = extract<double>(p);
+            double t0 = extract<double>(p);
+            double t1 = extract<double>(p);
+            uint32_t num_on = extract<uint32_t>(p);
+            uint32_t num_off = extract<uint32_t>(p);
+
+            uint64_t num_events = (uint64_t)num_on + num_off;
+            if (num_events > (uint64_t)(end - p) / (2 * sizeof(uint16_t))) {
+                throw std::runtime_error("Event log block is corrupt: " + filename);
+            }
+
+            const char* frame_events = p;
+            p += num_events * 2 * sizeof(uint16_t);
+
+            if (t < t_begin || t > t_end) {
+                continue;
+            }
+
+            on_events.clear();
+            off_events.clear();
+
+            const char* q = frame_events;
+            for (uint64_t i=0; i<num_events; i++) {
+                uint16_t x = extract<uint16_t>(q);
+                uint16_t y = extract<uint16_t>(q);
+                if (x < x_min || x > x_max || y < y_min || y > y_max) {
+                    continue;
+                }
+                std::vector<unsigned short>& events = i < num_on ? on_events : off_events;
+                events.push_back(x);
+                events.push_back(y);
+            }
+
+            if (on_events.empty() && off_events.empty()) {
+                continue;
+            }
+
+            results.push_back(std::make_shared<DVSEigenData>(
+                on_events.data(), on_events.size() / 2,
+                off_events.data(), off_events.size() / 2,
+                t, t0, t1));
+        }
+    }
+
+    return results;
+}
+
+} // namespace dvs
+} // namespace roboflex
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include "roboflex_dvs/flicker.h"
+
+namespace roboflex {
+namespace dvs {
+
+
+// -- DVSFlickerMarkers --
+
+DVSFlickerMarkers::DVSFlickerMarkers(const Markers& markers, double t):
+    core::Message(ModuleName, MessageName)
+{
+    flexbuffers::Builder fbb = get_builder();
+    WriteMapRoot(fbb, [&]() {
+        fbb.Double("t", t);
+        serialization::serialize_eigen_matrix(fbb, markers, "markers");
+    });
+}
+
+void DVSFlickerMarkers::print_on(ostream& os) const {
+    os << "<DVSFlickerMarkers"
+       << " t:" << get_t()
+       << " markers: " << get_markers().rows() << " ";
+    Message::print_on(os);
+    os << ">";
+}
+
+
+// -- DVSFlickerDetector --
+
+static const int NUM_PIXELS = 320 * 480;
+
+// How quickly a pixel's period estimate follows new intervals.
+static const float PERIOD_SMOOTHING = 0.25f;
+
+DVSFlickerDetector::DVSFlickerDetector(
+    float emit_frequency_hz,
+    const std::vector<double>& marker_frequencies,
+    double min_frequency,
+    double max_frequency,
+    double frequency_tolerance,
+    int min_stability,
+    int cell_size,
+    int min_pixels,
+    double event_period,
+    const std::string &name):
+        DVSPeriodicNode(emit_frequency_hz, event_period, name),
+        marker_frequencies(marker_frequencies),
+        min_period(1e6 / max_frequency),
+        max_period(1e6 / min_frequency),
+        frequency_tolerance(frequency_tolerance),
+        min_stability(std::clamp(min_stability, 1, 255)),
+        cell_size(std::max(1, cell_size)),
+        min_pixels(min_pixels),
+        last_on_t(NUM_PIXELS, 0),
+        last_off_t(NUM_PIXELS, 0),
+        period(NUM_PIXELS, 0.0f),
+        stability(NUM_PIXELS, 0),
+        is_candidate(NUM_PIXELS, 0)
+{
+
+}
+
+void DVSFlickerDetector::process_events(const DVSEigenData::DVSFrame& events, bool on_off, uint32_t t)
+{
+    uint32_t* last_t = on_off ? last_on_t.data() : last_off_t.data();
+
+    const unsigned short* xs = events.col(0).data();
+    const unsigned short* ys = events.col(1).data();
+    for (int i=0; i<events.rows(); i++) {
+        if (xs[i] >= 320 || ys[i] >= 480) {
+            continue;
+        }
+        uint32_t pixel = xs[i] * 480 + ys[i];
+        uint32_t& last = last_t[pixel];
+
+        if (last == 0 || t < last) {
+            last = t;
+            continue;
+        }
+
+        float dt = t - last;
+
+        // More events from the same transition.
+        if (dt < min_period) {
+            continue;
+        }
+
+        last = t;
+
+        float& p = period[pixel];
+        uint8_t& s = stability[pixel];
+
+        if (dt > max_period) {
+            p = 0;
+            s = 0;
+        } else if (p > 0 && std::abs(dt - p) <= frequency_tolerance * p) {
+            p += PERIOD_SMOOTHING * (dt - p);
+            if (s < 255) s += 1;
+        } else {
+            p = dt;
+            s = 0;
+        }
+
+        if (s >= min_stability && !is_candidate[pixel]) {
+            is_candidate[pixel] = 1;
+            candidates.push_back(pixel);
+        }
+    }
+}
+
+void DVSFlickerDetector::reset_pixels()
+{
+    std::fill(last_on_t.begin(), last_on_t.end(), 0);
+    std::fill(last_off_t.begin(), last_off_t.end(), 0);
+    std::fill(period.begin(), period.end(), 0.0f);
+    std::fill(stability.begin(), stability.end(), 0);
+    std::fill(is_candidate.begin(), is_candidate.end(), 0);
+    candidates.clear();
+}
+
+void DVSFlickerDetector::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    advance_event_time(input.get_t());
+
+    uint32_t t = (uint32_t)input.get_t();
+
+    const std::lock_guard<std::mutex> lock(state_mutex);
+
+    // Sensor time went backwards (it wrapped, or the sensor restarted):
+    // the intervals measured so far mean nothing now, so start over.
+    if (t < newest_t) {
+        reset_pixels();
+    }
+    newest_t = t;
+
+    process_events(input.get_on_events(), true, t);
+    process_events(input.get_off_events(), false, t);
+}
+
+int DVSFlickerDetector::frequency_group(double frequency) const
+{
+    if (marker_frequencies.empty()) {
+        return (int)std::floor(std::log(frequency) / std::log1p(frequency_tolerance));
+    }
+
+    int best = -1;
+    double best_error = frequency_tolerance;
+    for (size_t k=0; k<marker_frequencies.size(); k++) {
+        double error = std::abs(frequency - marker_frequencies[k]) / marker_frequencies[k];
+        if (error <= best_error) {
+            best = k;
+            best_error = error;
+        }
+    }
+    return best;
+}
+
+void DVSFlickerDetector::emit(double time)
+{
+    struct Cell {
+        double sum_x = 0, sum_y = 0, sum_frequency = 0;
+        int num_pixels = 0;
+        bool visited = false;
+    };
+
+    const int grid_rows = (320 + cell_size - 1) / cell_size;
+    const int grid_cols = (480 + cell_size - 1) / cell_size;
+    const int64_t num_cells = grid_rows * grid_cols;
+    const bool configured = !marker_frequencies.empty();
+
+    std::unordered_map<int64_t, Cell> cells;
+
+    {
+        const std::lock_guard<std::mutex> lock(state_mutex);
+
+        // Drop the candidates that stopped blinking, and bin the rest.
+        size_t kept = 0;
+        for (uint32_t pixel: candidates) {
+            uint32_t last_seen = std::max(last_on_t[pixel], last_off_t[pixel]);
+            if (stability[pixel] < min_stability || newest_t - last_seen > 2 * period[pixel]) {
+                is_candidate[pixel] = 0;
+                continue;
+            }
+            candidates[kept++] = pixel;
+
+            double frequency = 1e6 / period[pixel];
+            int group = frequency_group(frequency);
+            if (group < 0) {
+                continue;
+            }
+
+            int x = pixel / 480;
+            int y = pixel % 480;
+            Cell& cell = cells[group * num_cells + (x / cell_size) * grid_cols + (y / cell_size)];
+            cell.sum_x += x;
+            cell.sum_y += y;
+            cell.sum_frequency += frequency;
+            cell.num_pixels += 1;
+        }
+        candidates.resize(kept);
+    }
+
+    // Connected components of occupied cells, within each group.
+    std::vector<float> rows;
+    std::vector<int64_t> stack;
+    for (auto& [key, seed]: cells) {
+        if (seed.visited) {
+            continue;
+        }
+
+        int64_t group = key / num_cells;
+        double sum_x = 0, sum_y = 0, sum_frequency = 0;
+        int num_pixels = 0;
+
+        seed.visited = true;
+        stack.push_back(key);
+        while (!stack.empty()) {
+            int64_t k = stack.back();
+            stack.pop_back();
+            const Cell& cell = cells.find(k)->second;
+            sum_x += cell.sum_x;
+            sum_y += cell.sum_y;
+            sum_frequency += cell.sum_frequency;
+            num_pixels += cell.num_pixels;
+
+            int index = k - group * num_cells;
+            int r = index / grid_cols;
+            int c = index % grid_cols;
+            for (int dr=-1; dr<=1; dr++) {
+                for (int dc=-1; dc<=1; dc++) {
+                    int nr = r + dr, nc = c + dc;
+                    if (nr < 0 || nr >= grid_rows || nc < 0 || nc >= grid_cols) {
+                        continue;
+                    }
+                    auto it = cells.find(group * num_cells + nr * grid_cols + nc);
+                    if (it != cells.end() && !it->second.visited) {
+                        it->second.visited = true;
+                        stack.push_back(it->first);
+                    }
+                }
+            }
+        }
+
+        if (num_pixels >= min_pixels) {
+            rows.push_back(configured ? group : -1);
+            rows.push_back(sum_x / num_pixels);
+            rows.push_back(sum_y / num_pixels);
+            rows.push_back(sum_frequency / num_pixels);
+            rows.push_back(num_pixels);
+        }
+    }
+
+    DVSFlickerMarkers::Markers markers = Eigen::Map<const DVSFlickerMarkers::Markers>(rows.data(), rows.size() / 5, 5);
+    this->signal(std::make_shared<DVSFlickerMarkers>(markers, time));
+}
+
+} // namespace dvs
+} // namespace roboflex
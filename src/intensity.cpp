@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cmath>
+#include "roboflex_dvs/intensity.h"
+
+namespace roboflex {
+namespace dvs {
+
+// Sensor timestamps are in microseconds; decay_rate is per second.
+static const double MICROSECONDS = 1e-6;
+
+DVSIntensityReconstructor::DVSIntensityReconstructor(
+    float emit_frequency_hz,
+    float contrast_threshold,
+    float decay_rate,
+    float display_gain,
+    double event_period,
+    const std::string &name):
+        DVSPeriodicNode(emit_frequency_hz, event_period, name),
+        contrast_threshold(contrast_threshold),
+        decay_rate(decay_rate),
+        display_gain(display_gain),
+        log_intensity(LogIntensity::Zero(320, 480)),
+        last_update(Timestamps::Zero(320, 480))
+{
+    image.fill(128);
+}
+
+void DVSIntensityReconstructor::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    advance_event_time(input.get_t());
+
+    const DVSEigenData::DVSFrame on_events = input.get_on_events();
+    const DVSEigenData::DVSFrame off_events = input.get_off_events();
+    const double t = input.get_t();
+    const double rate = decay_rate * MICROSECONDS;
+
+    const std::lock_guard<std::mutex> lock(state_mutex);
+
+    // Sensor time went backwards (it wrapped, or the sensor restarted):
+    // decay everything up to where time was, and carry on from there.
+    if (t < latest_t) {
+        decay_to_latest();
+        last_update.setConstant(t);
+        latest_t = t;
+    }
+
+    auto update = [&](int x, int y, float step) {
+        double dt = std::max(0.0, t - last_update(x, y));
+        float& l = log_intensity(x, y);
+        l = l * std::exp((float)(-rate * dt)) + step;
+        last_update(x, y) = t;
+    };
+
+    for (int i=0; i<on_events.rows(); i++) {
+        update(on_events(i, 0), on_events(i, 1), contrast_threshold);
+    }
+
+    for (int i=0; i<off_events.rows(); i++) {
+        update(off_events(i, 0), off_events(i, 1), -contrast_threshold);
+    }
+
+    latest_t = t;
+}
+
+void DVSIntensityReconstructor::decay_to_latest()
+{
+    // Bring every pixel up to the latest event time, all at once.
+    log_intensity *= (-(decay_rate * MICROSECONDS) * (latest_t - last_update)).cast<float>().exp();
+    last_update.setConstant(latest_t);
+}
+
+DVSIntensityReconstructor::LogIntensity DVSIntensityReconstructor::get_log_intensity()
+{
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    decay_to_latest();
+    return log_intensity;
+}
+
+void DVSIntensityReconstructor::emit(double time)
+{
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    decay_to_latest();
+    image = (128.0f + display_gain * log_intensity).max(0.0f).min(255.0f).cast<uint8_t>().matrix();
+    this->signal(core::EigenMessage<uint8_t, 320, 480, Eigen::RowMajor>::Ptr(image, "DVSImage", "image"));
+}
+
+} // namespace dvs
+} // namespace roboflex
@@ -0,0 +1,69 @@
+#include <new>
+#include "roboflex_dvs/pool.h"
+
+namespace roboflex {
+namespace dvs {
+
+BlockPool::BlockPool(size_t max_free_blocks):
+    max_free_blocks(max_free_blocks)
+{
+    free_blocks.reserve(max_free_blocks);
+    stats.max_free_blocks = max_free_blocks;
+}
+
+BlockPool::~BlockPool()
+{
+    for (void* p: free_blocks) {
+        ::operator delete(p);
+    }
+}
+
+void* BlockPool::allocate(size_t num_bytes)
+{
+    {
+        const std::lock_guard<std::mutex> lock(pool_mutex);
+
+        if (stats.block_size == 0) {
+            stats.block_size = num_bytes;
+        }
+
+        if (num_bytes == stats.block_size && !free_blocks.empty()) {
+            void* p = free_blocks.back();
+            free_blocks.pop_back();
+            stats.hits += 1;
+            return p;
+        }
+
+        stats.misses += 1;
+    }
+
+    return ::operator new(num_bytes);
+}
+
+void BlockPool::deallocate(void* p, size_t num_bytes)
+{
+    {
+        const std::lock_guard<std::mutex> lock(pool_mutex);
+
+        if (num_bytes == stats.block_size && free_blocks.size() < max_free_blocks) {
+            free_blocks.push_back(p);
+            stats.recycled += 1;
+            return;
+        }
+
+        stats.released += 1;
+    }
+
+    ::operator delete(p);
+}
+
+BlockPoolStats BlockPool::get_stats() const
+{
+    const std::lock_guard<std::mutex> lock(pool_mutex);
+    BlockPoolStats s = stats;
+    s.free_blocks = free_blocks.size();
+    return s;
+}
+
+} // namespace dvs
+} // namespace roboflex
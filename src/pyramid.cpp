@@ -0,0 +1,109 @@
+#include <limits>
+#include "roboflex_dvs/pyramid.h"
+
+namespace roboflex {
+namespace dvs {
+
+static const char* LEVEL_KEYS[NumPyramidLevels] = {"level0", "level1", "level2", "level3"};
+
+
+// -- DVSEventPyramidData --
+
+DVSEventPyramidData::DVSEventPyramidData(
+    const std::array<CountImage, NumPyramidLevels>& levels,
+    int level_mask,
+    double t):
+        core::Message(ModuleName, MessageName)
+{
+    flexbuffers::Builder fbb = get_builder();
+    WriteMapRoot(fbb, [&]() {
+        fbb.Double("t", t);
+        fbb.Int("level_mask", level_mask);
+        for (int l=0; l<NumPyramidLevels; l++) {
+            if ((level_mask >> l) & 1) {
+                serialization::serialize_eigen_matrix(fbb, levels[l], LEVEL_KEYS[l]);
+            }
+        }
+    });
+}
+
+const DVSEventPyramidData::CountImage DVSEventPyramidData::get_level(int level) const
+{
+    if (level < 0 || level >= NumPyramidLevels || !has_level(level)) {
+        throw std::runtime_error("DVSEventPyramidData does not contain level " + std::to_string(level));
+    }
+    return serialization::deserialize_eigen_matrix<uint16_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>(root_val(LEVEL_KEYS[level]));
+}
+
+void DVSEventPyramidData::print_on(ostream& os) const {
+    os << "<DVSEventPyramidData"
+       << " t:" << get_t()
+       << " levels:";
+    for (int l=0; l<NumPyramidLevels; l++) {
+        if (has_level(l)) {
+            os << " " << l;
+        }
+    }
+    os << " ";
+    Message::print_on(os);
+    os << ">";
+}
+
+
+// -- DVSEventPyramid --
+
+DVSEventPyramid::DVSEventPyramid(
+    float emit_frequency_hz,
+    int level_mask,
+    double event_period,
+    const std::string &name):
+        DVSPeriodicNode(emit_frequency_hz, event_period, name),
+        level_mask(level_mask)
+{
+    for (int l=0; l<NumPyramidLevels; l++) {
+        counts[l] = DVSEventPyramidData::CountImage::Zero(320 >> l, 480 >> l);
+        if ((level_mask >> l) & 1) {
+            active_levels.push_back(l);
+        }
+    }
+}
+
+void DVSEventPyramid::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    advance_event_time(input.get_t());
+
+    const DVSEigenData::DVSFrame on_events = input.get_on_events();
+    const DVSEigenData::DVSFrame off_events = input.get_off_events();
+
+    const std::lock_guard<std::mutex> lock(counts_mutex);
+
+    std::array<uint16_t*, NumPyramidLevels> level_data;
+    for (int l=0; l<NumPyramidLevels; l++) {
+        level_data[l] = counts[l].data();
+    }
+
+    for (const DVSEigenData::DVSFrame* events: {&on_events, &off_events}) {
+        const unsigned short* xs = events->col(0).data();
+        const unsigned short* ys = events->col(1).data();
+        for (int i=0; i<events->rows(); i++) {
+            for (int l: active_levels) {
+                uint16_t& c = level_data[l][(xs[i] >> l) * (480 >> l) + (ys[i] >> l)];
+                if (c < std::numeric_limits<uint16_t>::max()) c += 1;
+            }
+        }
+    }
+}
+
+void DVSEventPyramid::emit(double time)
+{
+    const std::lock_guard<std::mutex> lock(counts_mutex);
+    this->signal(std::make_shared<DVSEventPyramidData>(counts, level_mask, time));
+    for (int l: active_levels) {
+        counts[l].setZero();
+    }
+}
+
+} // namespace dvs
+} // namespace roboflex
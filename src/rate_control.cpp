@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cmath>
+#include "roboflex_dvs/rate_control.h"
+
+namespace roboflex {
+namespace dvs {
+
+// Weight of the newest sample in the smoothed interval and processing time.
+static const double SMOOTHING = 0.05;
+
+// How quickly the keep fraction recovers once we're keeping up again.
+static const double RECOVERY_STEP = 0.05;
+
+DVSRateController::DVSRateController(
+    DegradationPolicy policy,
+    double max_lag,
+    double max_utilization,
+    double min_keep_fraction,
+    double control_period,
+    const std::string& name):
+        core::Node(name),
+        policy(policy),
+        max_lag(max_lag),
+        max_utilization(max_utilization),
+        min_keep_fraction(min_keep_fraction),
+        control_period(control_period)
+{
+
+}
+
+DVSRateControllerMetrics DVSRateController::get_metrics() const
+{
+    const std::lock_guard<std::mutex> lock(metrics_mutex);
+    return metrics;
+}
+
+void DVSRateController::update_control(double now, double lag)
+{
+    if (last_receive_time > 0) {
+        smoothed_interval += SMOOTHING * ((now - last_receive_time) - smoothed_interval);
+    }
+    last_receive_time = now;
+
+    double utilization = smoothed_interval > 0 ? smoothed_processing_time / smoothed_interval : 0.0;
+    bool overloaded = lag > max_lag || utilization > max_utilization;
+
+    const std::lock_guard<std::mutex> lock(metrics_mutex);
+    metrics.lag = lag;
+    metrics.utilization = utilization;
+
+    if (now - last_control_time < control_period) {
+        return;
+    }
+    last_control_time = now;
+
+    if (overloaded) {
+        metrics.keep_fraction = std::max(min_keep_fraction, metrics.keep_fraction * 0.5);
+    } else {
+        metrics.keep_fraction = std::min(1.0, metrics.keep_fraction + RECOVERY_STEP);
+    }
+
+    metrics.degrading = metrics.keep_fraction < 1.0;
+    spatial_stride = (int)std::ceil(std::sqrt(1.0 / metrics.keep_fraction));
+}
+
+bool DVSRateController::keep_event(bool on_off, int x, int y)
+{
+    switch (policy) {
+        case DegradationPolicy::RandomDecimation: {
+            // xorshift64: cheap and good enough for thinning events.
+            rng_state ^= rng_state << 13;
+            rng_state ^= rng_state >> 7;
+            rng_state ^= rng_state << 17;
+            return (rng_state >> 11) * (1.0 / 9007199254740992.0) < metrics.keep_fraction;
+        }
+        case DegradationPolicy::SpatialSubsampling:
+            return x % spatial_stride == 0 && y % spatial_stride == 0;
+        case DegradationPolicy::DropPolarity:
+            return on_off;
+        case DegradationPolicy::DropOldest:
+        default:
+            return true;
+    }
+}
+
+void DVSRateController::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    // Batches whose transfer time isn't known count as on time.
+    const DVSBatchMetadata metadata = input.get_metadata();
+    double now = core::get_current_time();
+    double lag = metadata.transfer_t1 > 0 ? now - metadata.transfer_t1 : 0.0;
+    update_control(now, lag);
+
+    const DVSEigenData::DVSFrame on_events = input.get_on_events();
+    const DVSEigenData::DVSFrame off_events = input.get_off_events();
+    unsigned long num_events = on_events.rows() + off_events.rows();
+
+    bool degrading;
+    unsigned long events_dropped;
+    {
+        const std::lock_guard<std::mutex> lock(metrics_mutex);
+        metrics.batches_in += 1;
+        metrics.events_in += num_events;
+        degrading = metrics.degrading;
+        events_dropped = metrics.events_dropped;
+
+        if (policy == DegradationPolicy::DropOldest && lag > max_lag) {
+            metrics.batches_dropped += 1;
+            metrics.events_dropped += num_events;
+            return;
+        }
+    }
+
+    core::MessagePtr output = m;
+    unsigned long num_kept = num_events;
+
+    // Once anything has been dropped here, batches are rebuilt even
+    // when none of their events are, to count the drops in their
+    // metadata.
+    bool thinning = degrading && policy != DegradationPolicy::DropOldest;
+
+    if (thinning || events_dropped > 0) {
+        kept_on_events.clear();
+        kept_off_events.clear();
+        kept_on_subpixel.clear();
+        kept_off_subpixel.clear();
+        kept_on_mask.assign(on_events.rows(), 0);
+        kept_off_mask.assign(off_events.rows(), 0);
+
+        bool with_subpixel = input.has_subpixel();
+        DVSEigenData::DVSSubpixelFrame on_subpixel, off_subpixel;
+        if (with_subpixel) {
+            on_subpixel = input.get_on_subpixel();
+            off_subpixel = input.get_off_subpixel();
+        }
+
+        for (int i=0; i<on_events.rows(); i++) {
+            if (!thinning || keep_event(true, on_events(i, 0), on_events(i, 1))) {
+                kept_on_mask[i] = 1;
+                kept_on_events.push_back(on_events(i, 0));
+                kept_on_events.push_back(on_events(i, 1));
+                if (with_subpixel) {
+                    kept_on_subpixel.push_back(on_subpixel(i, 0));
+                    kept_on_subpixel.push_back(on_subpixel(i, 1));
+                }
+            }
+        }
+
+        for (int i=0; i<off_events.rows(); i++) {
+            if (!thinning || keep_event(false, off_events(i, 0), off_events(i, 1))) {
+                kept_off_mask[i] = 1;
+                kept_off_events.push_back(off_events(i, 0));
+                kept_off_events.push_back(off_events(i, 1));
+                if (with_subpixel) {
+                    kept_off_subpixel.push_back(off_subpixel(i, 0));
+                    kept_off_subpixel.push_back(off_subpixel(i, 1));
+                }
+            }
+        }
+
+        num_kept = (kept_on_events.size() + kept_off_events.size()) / 2;
+
+        if (num_kept == 0) {
+            const std::lock_guard<std::mutex> lock(metrics_mutex);
+            metrics.batches_dropped += 1;
+            metrics.events_dropped += num_events;
+            return;
+        }
+
+        // The interleaved events list the on and off events in the same
+        // order as the separate frames, so the same choices apply.
+        bool with_interleaved = input.has_interleaved();
+        kept_interleaved.clear();
+        if (with_interleaved) {
+            const DVSEigenData::DVSInterleavedFrame events = input.get_interleaved_events();
+            int on_index = 0, off_index = 0;
+            for (int i=0; i<events.rows(); i++) {
+                bool on_off = events(i, 2) != 0;
+                bool kept = on_off ? kept_on_mask[on_index++] : kept_off_mask[off_index++];
+                if (kept) {
+                    kept_interleaved.push_back(events(i, 0));
+                    kept_interleaved.push_back(events(i, 1));
+                    kept_interleaved.push_back(events(i, 2));
+                    kept_interleaved.push_back(events(i, 3));
+                }
+            }
+        }
+
+        DVSBatchMetadata output_metadata = metadata;
+        output_metadata.dropped_events += events_dropped + (num_events - num_kept);
+
+        output = eigen_data_pool.make(
+            kept_on_events.data(), kept_on_events.size() / 2,
+            kept_off_events.data(), kept_off_events.size() / 2,
+            input.get_t(), input.get_t0(), input.get_t1(),
+            output_metadata,
+            with_subpixel ? kept_on_subpixel.data() : nullptr,
+            with_subpixel ? kept_off_subpixel.data() : nullptr,
+            with_interleaved ? kept_interleaved.data() : nullptr);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(metrics_mutex);
+        metrics.batches_out += 1;
+        metrics.events_out += num_kept;
+        metrics.events_dropped += num_events - num_kept;
+    }
+
+    // Downstream runs synchronously, so this is how long the consumers take.
+    double t_signal = core::get_current_time();
+    this->signal(output);
+    double processing_time = core::get_current_time() - t_signal;
+    smoothed_processing_time += SMOOTHING * (processing_time - smoothed_processing_time);
+}
+
+} // namespace dvs
+} // namespace roboflex
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include "roboflex_dvs/sparse.h"
+
+namespace roboflex {
+namespace dvs {
+
+static const int NUM_PIXELS = 320 * 480;
+static const int NUM_WORDS = NUM_PIXELS / 64;
+
+
+// -- DVSSparseFrameData --
+
+DVSSparseFrameData::DVSSparseFrameData(
+    SparseLayout layout,
+    const IndexVector& rows,
+    const IndexVector& cols,
+    const OffsetVector& row_ptr,
+    const CountVector& on_counts,
+    const CountVector& off_counts,
+    const TimeVector& latest_t,
+    double t):
+        core::Message(ModuleName, MessageName)
+{
+    flexbuffers::Builder fbb = get_builder();
+    WriteMapRoot(fbb, [&]() {
+        fbb.Double("t", t);
+        fbb.Int("num_active", cols.size());
+        serialization::serialize_eigen_matrix(fbb, cols, "cols");
+        if (layout != SparseLayout::CSR) {
+            serialization::serialize_eigen_matrix(fbb, rows, "rows");
+        }
+        if (layout != SparseLayout::COO) {
+            serialization::serialize_eigen_matrix(fbb, row_ptr, "row_ptr");
+        }
+        serialization::serialize_eigen_matrix(fbb, on_counts, "on_counts");
+        serialization::serialize_eigen_matrix(fbb, off_counts, "off_counts");
+        serialization::serialize_eigen_matrix(fbb, latest_t, "latest_t");
+    });
+}
+
+const DVSSparseFrameData::IndexVector DVSSparseFrameData::get_rows() const
+{
+    if (!has_coo()) {
+        throw std::runtime_error("DVSSparseFrameData does not contain the COO layout");
+    }
+    return serialization::deserialize_eigen_matrix<uint16_t, Eigen::Dynamic, 1>(root_val("rows"));
+}
+
+const DVSSparseFrameData::IndexVector DVSSparseFrameData::get_cols() const
+{
+    return serialization::deserialize_eigen_matrix<uint16_t, Eigen::Dynamic, 1>(root_val("cols"));
+}
+
+const DVSSparseFrameData::OffsetVector DVSSparseFrameData::get_row_ptr() const
+{
+    if (!has_csr()) {
+        throw std::runtime_error("DVSSparseFrameData does not contain the CSR layout");
+    }
+    return serialization::deserialize_eigen_matrix<uint32_t, Eigen::Dynamic, 1>(root_val("row_ptr"));
+}
+
+const DVSSparseFrameData::CountVector DVSSparseFrameData::get_on_counts() const
+{
+    return serialization::deserialize_eigen_matrix<uint16_t, Eigen::Dynamic, 1>(root_val("on_counts"));
+}
+
+const DVSSparseFrameData::CountVector DVSSparseFrameData::get_off_counts() const
+{
+    return serialization::deserialize_eigen_matrix<uint16_t, Eigen::Dynamic, 1>(root_val("off_counts"));
+}
+
+const DVSSparseFrameData::TimeVector DVSSparseFrameData::get_latest_t() const
+{
+    return serialization::deserialize_eigen_matrix<uint32_t, Eigen::Dynamic, 1>(root_val("latest_t"));
+}
+
+void DVSSparseFrameData::print_on(ostream& os) const {
+    os << "<DVSSparseFrameData"
+       << " t:" << get_t()
+       << " active: " << get_num_active()
+       << (has_coo() ? " coo" : "")
+       << (has_csr() ? " csr" : "") << " ";
+    Message::print_on(os);
+    os << ">";
+}
+
+
+// -- DVSSparseFrameBuilder --
+
+DVSSparseFrameBuilder::DVSSparseFrameBuilder(
+    float emit_frequency_hz,
+    SparseLayout layout,
+    double event_period,
+    const std::string &name):
+        DVSPeriodicNode(emit_frequency_hz, event_period, name),
+        layout(layout),
+        active_bits(NUM_WORDS, 0),
+        on_counts(NUM_PIXELS, 0),
+        off_counts(NUM_PIXELS, 0),
+        latest_t(NUM_PIXELS, 0)
+{
+
+}
+
+void DVSSparseFrameBuilder::add_events(const DVSEigenData::DVSFrame& events, bool on_off, uint32_t t)
+{
+    std::vector<uint16_t>& counts = on_off ? on_counts : off_counts;
+
+    const unsigned short* xs = events.col(0).data();
+    const unsigned short* ys = events.col(1).data();
+    for (int i=0; i<events.rows(); i++) {
+        if (xs[i] >= 320 || ys[i] >= 480) {
+            continue;
+        }
+        uint32_t pixel = xs[i] * 480 + ys[i];
+        uint64_t bit = uint64_t(1) << (pixel & 63);
+        uint64_t& word = active_bits[pixel >> 6];
+        if (!(word & bit)) {
+            word |= bit;
+            active_pixels.push_back(pixel);
+        }
+        if (counts[pixel] < std::numeric_limits<uint16_t>::max()) {
+            counts[pixel] += 1;
+        }
+        latest_t[pixel] = std::max(latest_t[pixel], t);
+    }
+}
+
+void DVSSparseFrameBuilder::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    advance_event_time(input.get_t());
+
+    uint32_t t = (uint32_t)input.get_t();
+
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    add_events(input.get_on_events(), true, t);
+    add_events(input.get_off_events(), false, t);
+}
+
+void DVSSparseFrameBuilder::sort_active_pixels()
+{
+    // Pixel index is x*480 + y, so sorting by index is row-major order.
+    // Once most of the bitset is in use, walking it is cheaper than sorting.
+    if (active_pixels.size() < NUM_WORDS) {
+        std::sort(active_pixels.begin(), active_pixels.end());
+        return;
+    }
+
+    active_pixels.clear();
+    for (int w=0; w<NUM_WORDS; w++) {
+        uint64_t word = active_bits[w];
+        while (word) {
+            active_pixels.push_back(w * 64 + std::countr_zero(word));
+            word &= word - 1;
+        }
+    }
+}
+
+void DVSSparseFrameBuilder::emit(double time)
+{
+    const std::lock_guard<std::mutex> lock(state_mutex);
+
+    sort_active_pixels();
+
+    const int n = active_pixels.size();
+    DVSSparseFrameData::IndexVector rows(layout != SparseLayout::CSR ? n : 0);
+    DVSSparseFrameData::IndexVector cols(n);
+    DVSSparseFrameData::OffsetVector row_ptr(layout != SparseLayout::COO ? 321 : 0);
+    DVSSparseFrameData::CountVector on(n), off(n);
+    DVSSparseFrameData::TimeVector latest(n);
+
+    if (row_ptr.size() > 0) {
+        row_ptr.setZero();
+    }
+
+    for (int i=0; i<n; i++) {
+        uint32_t pixel = active_pixels[i];
+        uint16_t x = pixel / 480;
+        cols[i] = pixel % 480;
+        if (rows.size() > 0) {
+            rows[i] = x;
+        }
+        if (row_ptr.size() > 0) {
+            row_ptr[x + 1] += 1;
+        }
+        on[i] = on_counts[pixel];
+        off[i] = off_counts[pixel];
+        latest[i] = latest_t[pixel];
+
+        // Reset as we go: only the pixels that were touched.
+        on_counts[pixel] = 0;
+        off_counts[pixel] = 0;
+        latest_t[pixel] = 0;
+        active_bits[pixel >> 6] &= ~(uint64_t(1) << (pixel & 63));
+    }
+
+    for (int x=0; x<(int)row_ptr.size() - 1; x++) {
+        row_ptr[x + 1] += row_ptr[x];
+    }
+
+    active_pixels.clear();
+
+    this->signal(std::make_shared<DVSSparseFrameData>(layout, rows, cols, row_ptr, on, off, latest, time));
+}
+
+} // namespace dvs
+} // namespace roboflex
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "roboflex_dvs/thread_tuning.h"
+
+namespace roboflex {
+namespace dvs {
+
+static bool is_valid_core(int core)
+{
+    long num_online = sysconf(_SC_NPROCESSORS_ONLN);
+    return core >= 0 && core < CPU_SETSIZE && (num_online <= 0 || core < num_online);
+}
+
+void validate_thread_options(const DVSThreadOptions& options)
+{
+    for (int core: options.cpu_cores) {
+        if (!is_valid_core(core)) {
+            throw std::runtime_error("Invalid cpu core " + std::to_string(core) +
+                ": " + std::to_string(sysconf(_SC_NPROCESSORS_ONLN)) + " cpus are online");
+        }
+    }
+}
+
+bool apply_thread_options(const DVSThreadOptions& options, const std::string& thread_name)
+{
+    bool ok = true;
+
+    if (!options.cpu_cores.empty()) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (int core: options.cpu_cores) {
+            if (!is_valid_core(core)) {
+                std::cerr << thread_name << ": ignoring invalid cpu core " << core << std::endl;
+                ok = false;
+                continue;
+            }
+            CPU_SET(core, &cpuset);
+        }
+        int r = CPU_COUNT(&cpuset) == 0 ? EINVAL : pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        if (r != 0) {
+            std::cerr << thread_name << ": unable to set cpu affinity: " << strerror(r) << std::endl;
+            ok = false;
+        }
+    }
+
+    if (options.scheduling_policy != DVSSchedulingPolicy::Default) {
+        int policy = options.scheduling_policy == DVSSchedulingPolicy::Fifo ? SCHED_FIFO : SCHED_RR;
+        sched_param param;
+        param.sched_priority = options.scheduling_priority;
+        int r = pthread_setschedparam(pthread_self(), policy, &param);
+        if (r != 0) {
+            std::cerr << thread_name << ": unable to set realtime scheduling: " << strerror(r) << std::endl;
+            ok = false;
+        }
+    }
+
+    // Not MCL_FUTURE: that would make every later allocation in the
+    // process, not just ours, count against RLIMIT_MEMLOCK.
+    if (options.lock_memory) {
+        if (mlockall(MCL_CURRENT) != 0) {
+            std::cerr << thread_name << ": unable to lock memory: " << strerror(errno) << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+
+// -- JitterHistogram --
+
+void JitterHistogram::record(double interval_seconds)
+{
+    double usec = interval_seconds * 1e6;
+    int bucket = usec < 1.0 ? 0 : std::min(NumBuckets - 1, (int)std::log2(usec) + 1);
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    num_samples.fetch_add(1, std::memory_order_relaxed);
+
+    // Only the recording thread writes this, so no compare-exchange needed.
+    if (interval_seconds > max_interval.load(std::memory_order_relaxed)) {
+        max_interval.store(interval_seconds, std::memory_order_relaxed);
+    }
+}
+
+void JitterHistogram::reset()
+{
+    for (auto& count: counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    num_samples.store(0, std::memory_order_relaxed);
+    max_interval.store(0.0, std::memory_order_relaxed);
+}
+
+std::vector<unsigned long> JitterHistogram::get_counts() const
+{
+    std::vector<unsigned long> result(NumBuckets);
+    for (int i=0; i<NumBuckets; i++) {
+        result[i] = counts[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::vector<double> JitterHistogram::get_bucket_limits()
+{
+    std::vector<double> limits(NumBuckets);
+    for (int i=0; i<NumBuckets; i++) {
+        limits[i] = i == NumBuckets - 1 ? INFINITY : std::ldexp(1.0, i);
+    }
+    return limits;
+}
+
+} // namespace dvs
+} // namespace roboflex
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+#include "roboflex_dvs/tracing.h"
+
+namespace roboflex {
+namespace dvs {
+
+namespace detail {
+std::atomic<bool> tracing_enabled{false};
+}
+
+static uint32_t current_thread_id()
+{
+    static std::atomic<uint32_t> next_thread_id{1};
+    thread_local uint32_t thread_id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+    return thread_id;
+}
+
+
+// -- DVSTraceRing --
+
+DVSTraceRing::DVSTraceRing(size_t capacity):
+    capacity(std::max<size_t>(1, capacity)),
+    slots(new Slot[this->capacity])
+{
+
+}
+
+void DVSTraceRing::record(const char* name, uint64_t transfer_id, double t_begin, double t_end)
+{
+    uint64_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[index % capacity];
+
+    // A per-slot sequence lock: 0 while being written, index+1 after.
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.span.name = name;
+    slot.span.transfer_id = transfer_id;
+    slot.span.t_begin = t_begin;
+    slot.span.t_end = t_end;
+    slot.span.thread_id = current_thread_id();
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+std::vector<DVSTraceSpan> DVSTraceRing::get_spans() const
+{
+    uint64_t end = next_index.load(std::memory_order_acquire);
+    uint64_t begin = end > capacity ? end - capacity : 0;
+
+    std::vector<DVSTraceSpan> spans;
+    spans.reserve(end - begin);
+
+    for (uint64_t index = begin; index < end; index++) {
+        const Slot& slot = slots[index % capacity];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        DVSTraceSpan span = slot.span;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+        if (before == index + 1 && after == before) {
+            spans.push_back(span);
+        }
+    }
+
+    return spans;
+}
+
+void DVSTraceRing::clear()
+{
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    next_index.store(0, std::memory_order_release);
+}
+
+void DVSTraceRing::write_chrome_trace(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Unable to open trace file for writing: " + filename);
+    }
+
+    const int pid = getpid();
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    for (const DVSTraceSpan& span: get_spans()) {
+        file << (first ? "\n" : ",\n")
+             << "{\"name\":\"" << (span.name ? span.name : "") << "\""
+             << ",\"cat\":\"dvs\",\"ph\":\"X\""
+             << ",\"ts\":" << span.t_begin * 1e6
+             << ",\"dur\":" << std::max(0.0, span.t_end - span.t_begin) * 1e6
+             << ",\"pid\":" << pid
+             << ",\"tid\":" << span.thread_id
+             << ",\"args\":{\"transfer_id\":" << span.transfer_id << "}}";
+        first = false;
+    }
+
+    file << "\n]}\n";
+
+    if (!file) {
+        throw std::runtime_error("Error writing trace file: " + filename);
+    }
+}
+
+
+// -- global tracing --
+
+// The current ring is published through an atomic pointer, so the
+// nodes can record without taking a lock. Rings are only ever replaced,
+// never freed: a node may still be recording into the one it loaded.
+static std::mutex trace_ring_mutex;
+static std::atomic<DVSTraceRing*> trace_ring{nullptr};
+static std::vector<std::unique_ptr<DVSTraceRing>> trace_rings;
+
+static DVSTraceRing* publish_trace_ring(size_t capacity)
+{
+    trace_rings.push_back(std::make_unique<DVSTraceRing>(capacity));
+    DVSTraceRing* ring = trace_rings.back().get();
+    trace_ring.store(ring, std::memory_order_release);
+    return ring;
+}
+
+void enable_tracing(size_t capacity)
+{
+    const std::lock_guard<std::mutex> lock(trace_ring_mutex);
+    DVSTraceRing* ring = trace_ring.load(std::memory_order_acquire);
+    if (ring == nullptr || ring->get_capacity() != capacity) {
+        publish_trace_ring(capacity);
+    }
+    detail::tracing_enabled.store(true);
+}
+
+void disable_tracing()
+{
+    detail::tracing_enabled.store(false);
+}
+
+DVSTraceRing& get_trace_ring()
+{
+    DVSTraceRing* ring = trace_ring.load(std::memory_order_acquire);
+    if (ring != nullptr) {
+        return *ring;
+    }
+
+    // Before tracing is first enabled, this is an empty default ring.
+    const std::lock_guard<std::mutex> lock(trace_ring_mutex);
+    ring = trace_ring.load(std::memory_order_acquire);
+    return ring != nullptr ? *ring : *publish_trace_ring(65536);
+}
+
+} // namespace dvs
+} // namespace roboflex
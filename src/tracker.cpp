@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cmath>
+#include "roboflex_dvs/tracker.h"
+
+namespace roboflex {
+namespace dvs {
+
+
+// -- DVSClusterTracks --
+
+DVSClusterTracks::DVSClusterTracks(const Tracks& tracks, double t, double t0, double t1):
+    core::Message(ModuleName, MessageName)
+{
+    flexbuffers::Builder fbb = get_builder();
+    WriteMapRoot(fbb, [&]() {
+        fbb.Double("t", t);
+        fbb.Double("t0", t0);
+        fbb.Double("t1", t1);
+        serialization::serialize_eigen_matrix(fbb, tracks, "tracks");
+    });
+}
+
+void DVSClusterTracks::print_on(ostream& os) const {
+    os << "<DVSClusterTracks"
+       << " times: (" << get_t0() << " - " << get_t1() << ")"
+       << " t:" << get_t()
+       << " tracks: " << get_tracks().rows() << " ";
+    Message::print_on(os);
+    os << ">";
+}
+
+
+// -- DVSClusterTracker --
+
+// How many clusters are checked for idleness per event.
+static const int PRUNE_PER_EVENT = 2;
+
+// Velocities are re-estimated over at least this much event time (usec).
+static const double VELOCITY_WINDOW = 1000.0;
+
+DVSClusterTracker::DVSClusterTracker(
+    float cluster_radius,
+    int max_clusters,
+    float min_activity,
+    double activity_time_constant,
+    double idle_timeout,
+    float mixing_factor,
+    const std::string& name):
+        core::Node(name),
+        cluster_radius(cluster_radius),
+        max_clusters(max_clusters),
+        min_activity(min_activity),
+        activity_time_constant(activity_time_constant),
+        idle_timeout(idle_timeout),
+        mixing_factor(mixing_factor),
+        grid_rows(cluster_radius > 0 ? (int)std::ceil(320 / cluster_radius) : 0),
+        grid_cols(cluster_radius > 0 ? (int)std::ceil(480 / cluster_radius) : 0),
+        grid(grid_rows * grid_cols),
+        clusters(std::max(0, max_clusters))
+{
+    if (max_clusters <= 0) {
+        throw std::runtime_error("DVSClusterTracker: max_clusters must be positive");
+    }
+    if (!(cluster_radius > 0)) {
+        throw std::runtime_error("DVSClusterTracker: cluster_radius must be positive");
+    }
+
+    for (int i=max_clusters-1; i>=0; i--) {
+        clusters[i].alive = false;
+        free_slots.push_back(i);
+    }
+}
+
+int DVSClusterTracker::cell_of(float x, float y) const
+{
+    int r = std::clamp((int)(x / cluster_radius), 0, grid_rows - 1);
+    int c = std::clamp((int)(y / cluster_radius), 0, grid_cols - 1);
+    return r * grid_cols + c;
+}
+
+void DVSClusterTracker::move_to_cell(int index, int cell)
+{
+    Cluster& c = clusters[index];
+    if (c.cell == cell) {
+        return;
+    }
+
+    if (c.cell >= 0) {
+        std::vector<int>& old_cell = grid[c.cell];
+        auto it = std::find(old_cell.begin(), old_cell.end(), index);
+        *it = old_cell.back();
+        old_cell.pop_back();
+    }
+
+    if (cell >= 0) {
+        grid[cell].push_back(index);
+    }
+
+    c.cell = cell;
+}
+
+void DVSClusterTracker::rebin_predicted(double t)
+{
+    // Bin every cluster where it should be at t, which is where events
+    // are compared against, so the 3x3 cells around an event hold every
+    // cluster that could claim it, however fast the cluster moves.
+    for (int index=0; index<max_clusters; index++) {
+        const Cluster& c = clusters[index];
+        if (c.alive) {
+            float dt = (float)((t - c.last_t) * 1e-6);
+            move_to_cell(index, cell_of(c.x + c.vx * dt, c.y + c.vy * dt));
+        }
+    }
+}
+
+int DVSClusterTracker::find_cluster(int x, int y, double t) const
+{
+    int r0 = std::clamp((int)(x / cluster_radius), 0, grid_rows - 1);
+    int c0 = std::clamp((int)(y / cluster_radius), 0, grid_cols - 1);
+
+    int best = -1;
+    float best_d2 = cluster_radius * cluster_radius;
+
+    for (int r=std::max(0, r0-1); r<=std::min(grid_rows-1, r0+1); r++) {
+        for (int c=std::max(0, c0-1); c<=std::min(grid_cols-1, c0+1); c++) {
+            for (int index: grid[r * grid_cols + c]) {
+                const Cluster& cl = clusters[index];
+
+                // Compare against where the cluster should be by now.
+                float dt = (float)((t - cl.last_t) * 1e-6);
+                float dx = x - (cl.x + cl.vx * dt);
+                float dy = y - (cl.y + cl.vy * dt);
+                float d2 = dx * dx + dy * dy;
+                if (d2 <= best_d2) {
+                    best_d2 = d2;
+                    best = index;
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+void DVSClusterTracker::update_cluster(Cluster& c, int x, int y, double t)
+{
+    float a = mixing_factor;
+    float dt = (float)((t - c.last_t) * 1e-6);
+
+    c.activity = c.activity * (float)std::exp(-(t - c.last_t) / activity_time_constant) + 1.0f;
+
+    float px = c.x + c.vx * dt;
+    float py = c.y + c.vy * dt;
+    float dx = x - px;
+    float dy = y - py;
+
+    c.x = px + a * dx;
+    c.y = py + a * dy;
+    c.cxx = (1 - a) * c.cxx + a * dx * dx;
+    c.cxy = (1 - a) * c.cxy + a * dx * dy;
+    c.cyy = (1 - a) * c.cyy + a * dy * dy;
+    c.last_t = t;
+
+    if (t - c.anchor_t >= VELOCITY_WINDOW) {
+        float window = (float)((t - c.anchor_t) * 1e-6);
+        c.vx = (1 - a) * c.vx + a * (c.x - c.anchor_x) / window;
+        c.vy = (1 - a) * c.vy + a * (c.y - c.anchor_y) / window;
+        c.anchor_x = c.x;
+        c.anchor_y = c.y;
+        c.anchor_t = t;
+    }
+
+    c.last_batch = batch_count;
+}
+
+void DVSClusterTracker::spawn_cluster(int x, int y, double t)
+{
+    if (free_slots.empty()) {
+        return;
+    }
+
+    int index = free_slots.back();
+    free_slots.pop_back();
+
+    Cluster& c = clusters[index];
+    c.id = next_id++;
+    c.alive = true;
+    c.x = x;
+    c.y = y;
+    c.vx = 0;
+    c.vy = 0;
+    c.cxx = cluster_radius * cluster_radius / 4;
+    c.cxy = 0;
+    c.cyy = cluster_radius * cluster_radius / 4;
+    c.activity = 1;
+    c.last_t = t;
+    c.anchor_x = x;
+    c.anchor_y = y;
+    c.anchor_t = t;
+    c.cell = -1;
+    c.last_batch = batch_count;
+
+    move_to_cell(index, cell_of(c.x, c.y));
+    num_alive += 1;
+}
+
+void DVSClusterTracker::remove_cluster(int index)
+{
+    move_to_cell(index, -1);
+    clusters[index].alive = false;
+    free_slots.push_back(index);
+    num_alive -= 1;
+}
+
+void DVSClusterTracker::remove_all_clusters()
+{
+    for (int index=0; index<max_clusters; index++) {
+        if (clusters[index].alive) {
+            remove_cluster(index);
+        }
+    }
+}
+
+void DVSClusterTracker::prune_some(double t)
+{
+    for (int i=0; i<PRUNE_PER_EVENT; i++) {
+        prune_cursor = (prune_cursor + 1) % max_clusters;
+        const Cluster& c = clusters[prune_cursor];
+        if (c.alive && t - c.last_t > idle_timeout) {
+            remove_cluster(prune_cursor);
+        }
+    }
+}
+
+void DVSClusterTracker::process_event(int x, int y, double t)
+{
+    int index = find_cluster(x, y, t);
+
+    if (index >= 0) {
+        Cluster& c = clusters[index];
+        update_cluster(c, x, y, t);
+        move_to_cell(index, cell_of(c.x, c.y));
+    } else {
+        spawn_cluster(x, y, t);
+    }
+
+    prune_some(t);
+}
+
+void DVSClusterTracker::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    const DVSEigenData::DVSFrame on_events = input.get_on_events();
+    const DVSEigenData::DVSFrame off_events = input.get_off_events();
+    const double t = input.get_t();
+
+    batch_count += 1;
+
+    // Sensor time went backwards (it wrapped, or the sensor restarted):
+    // activities, velocities and idle times would all come out wrong
+    // against the old times, so the tracks start over.
+    if (t < latest_t) {
+        remove_all_clusters();
+    }
+    latest_t = t;
+
+    rebin_predicted(t);
+
+    for (int i=0; i<on_events.rows(); i++) {
+        process_event(on_events(i, 0), on_events(i, 1), t);
+    }
+
+    for (int i=0; i<off_events.rows(); i++) {
+        process_event(off_events(i, 0), off_events(i, 1), t);
+    }
+
+    int num_updated = 0;
+    for (const Cluster& c: clusters) {
+        if (c.alive && c.last_batch == batch_count && c.activity >= min_activity) {
+            num_updated += 1;
+        }
+    }
+
+    if (num_updated == 0) {
+        return;
+    }
+
+    DVSClusterTracks::Tracks tracks(num_updated, 9);
+    int row = 0;
+    for (const Cluster& c: clusters) {
+        if (c.alive && c.last_batch == batch_count && c.activity >= min_activity) {
+            tracks.row(row++) << (float)c.id, c.x, c.y, c.vx, c.vy, c.cxx, c.cxy, c.cyy, c.activity;
+        }
+    }
+
+    this->signal(std::make_shared<DVSClusterTracks>(tracks, t, input.get_t0(), input.get_t1()));
+}
+
+} // namespace dvs
+} // namespace roboflex
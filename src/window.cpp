@@ -0,0 +1,193 @@
+#include <algorithm>
+#include "roboflex_dvs/window.h"
+
+namespace roboflex {
+namespace dvs {
+
+// -- DVSEventWindowView --
+
+bool DVSEventWindowView::is_valid() const
+{
+    if (window == nullptr) {
+        return true;
+    }
+
+    // Order the reads of the events before the read of the counter.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return window->write_end.load(std::memory_order_relaxed) <= begin_index + window->capacity;
+}
+
+
+// -- DVSEventWindow --
+
+DVSEventWindow::DVSEventWindow(
+    double window_duration,
+    size_t capacity,
+    const std::string &name):
+        core::Node(name),
+        window_duration(window_duration),
+        capacity(std::max<size_t>(1, capacity)),
+        events(new DVSWindowEvent[this->capacity])
+{
+
+}
+
+size_t DVSEventWindow::get_num_events() const
+{
+    uint64_t t = tail.load(std::memory_order_acquire);
+    uint64_t h = head.load(std::memory_order_acquire);
+    return h > t ? h - t : 0;
+}
+
+void DVSEventWindow::append(const DVSEigenData::DVSFrame& frame, bool on_off, uint32_t t)
+{
+    uint64_t h = head.load(std::memory_order_relaxed);
+    uint64_t n = frame.rows();
+
+    // A batch bigger than the whole ring only keeps its last events.
+    uint64_t skip = n > capacity ? n - capacity : 0;
+    n -= skip;
+
+    // Drop whatever is about to be overwritten, before overwriting it.
+    uint64_t tl = tail.load(std::memory_order_relaxed);
+    if (h + n > tl + capacity) {
+        num_overflowed.fetch_add(h + n - capacity - tl, std::memory_order_relaxed);
+        tail.store(h + n - capacity, std::memory_order_release);
+    }
+    num_overflowed.fetch_add(skip, std::memory_order_relaxed);
+
+    // Readers of the slots we're about to reuse can tell from this.
+    write_end.store(h + n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const unsigned short* xs = frame.col(0).data();
+    const unsigned short* ys = frame.col(1).data();
+    for (uint64_t i=0; i<n; i++) {
+        DVSWindowEvent& e = events[(h + i) % capacity];
+        e.t = t;
+        e.x = xs[skip + i];
+        e.y = ys[skip + i];
+        e.polarity = on_off ? 1 : 0;
+    }
+
+    head.store(h + n, std::memory_order_release);
+}
+
+void DVSEventWindow::expire(uint32_t newest_t)
+{
+    uint64_t h = head.load(std::memory_order_relaxed);
+    uint64_t tl = tail.load(std::memory_order_relaxed);
+    uint64_t new_tail = tl;
+    while (new_tail < h && events[new_tail % capacity].t + window_duration < newest_t) {
+        new_tail += 1;
+    }
+    if (new_tail != tl) {
+        tail.store(new_tail, std::memory_order_release);
+    }
+}
+
+void DVSEventWindow::receive(core::MessagePtr m)
+{
+    DVSEigenData input(*m);
+
+    uint32_t t = (uint32_t)input.get_t();
+
+    if (has_newest && t < newest_t) {
+        tail.store(head.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+    has_newest = true;
+    newest_t = t;
+
+    append(input.get_on_events(), true, t);
+    append(input.get_off_events(), false, t);
+    expire(t);
+
+    this->signal(m);
+}
+
+uint64_t DVSEventWindow::lower_bound(uint64_t begin, uint64_t end, double t) const
+{
+    while (begin < end) {
+        uint64_t mid = begin + (end - begin) / 2;
+        if (events[mid % capacity].t < t) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+DVSEventWindowView DVSEventWindow::make_view(uint64_t begin, uint64_t end) const
+{
+    DVSEventWindowView view;
+    view.window = this;
+    view.begin_index = begin;
+
+    size_t n = end - begin;
+    size_t start = begin % capacity;
+    size_t first = std::min(n, capacity - start);
+    view.spans[0] = {events.get() + start, first};
+    view.spans[1] = {events.get(), n - first};
+    return view;
+}
+
+DVSEventWindowView DVSEventWindow::query(double t_begin, double t_end) const
+{
+    uint64_t tl = tail.load(std::memory_order_acquire);
+    uint64_t h = head.load(std::memory_order_acquire);
+    if (h <= tl || t_end <= t_begin) {
+        return make_view(h, h);
+    }
+
+    uint64_t begin = lower_bound(tl, h, t_begin);
+    uint64_t end = lower_bound(begin, h, t_end);
+    return make_view(begin, end);
+}
+
+DVSEventWindowView DVSEventWindow::query_latest(double duration) const
+{
+    uint64_t tl = tail.load(std::memory_order_acquire);
+    uint64_t h = head.load(std::memory_order_acquire);
+    if (h <= tl) {
+        return make_view(h, h);
+    }
+
+    double newest = events[(h - 1) % capacity].t;
+    return query(newest - duration, newest + 1);
+}
+
+template <typename Query>
+static DVSRawPacket::DVSEventList copy_consistent(Query query)
+{
+    DVSRawPacket::DVSEventList result;
+    while (true) {
+        DVSEventWindowView view = query();
+        result.resize(view.size(), 4);
+        size_t row = 0;
+        for (const DVSWindowSpan& span: view.get_spans()) {
+            for (size_t i=0; i<span.size; i++, row++) {
+                result(row, 0) = span.data[i].t;
+                result(row, 1) = span.data[i].x;
+                result(row, 2) = span.data[i].y;
+                result(row, 3) = span.data[i].polarity;
+            }
+        }
+        if (view.is_valid()) {
+            return result;
+        }
+    }
+}
+
+DVSRawPacket::DVSEventList DVSEventWindow::get_events(double t_begin, double t_end) const
+{
+    return copy_consistent([&]() { return query(t_begin, t_end); });
+}
+
+DVSRawPacket::DVSEventList DVSEventWindow::get_latest_events(double duration) const
+{
+    return copy_consistent([&]() { return query_latest(duration); });
+}
+
+} // namespace dvs
+} // namespace roboflex
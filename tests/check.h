@@ -0,0 +1,17 @@
+#ifndef ROBOFLEX_DVS_TESTS_CHECK__H
+#define ROBOFLEX_DVS_TESTS_CHECK__H
+
+#include <cstdlib>
+#include <iostream>
+
+// The tests are plain programs, run by ctest: a failed CHECK
+// reports where, and fails the test.
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << std::endl; \
+            std::exit(1); \
+        } \
+    } while (0)
+
+#endif // ROBOFLEX_DVS_TESTS_CHECK__H
@@ -0,0 +1,97 @@
+#include "roboflex_dvs/bias.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+// The simulated sensor, decoded a millisecond at a time, into the
+// bias controller, with events wanted at 20k to 200k per second.
+struct Pipeline {
+    Pipeline(double scene_event_rate, int min_bias = 0x00, int max_bias = 0x3F):
+        sensor(std::make_shared<DVSSimulatedSensor>(scene_event_rate)),
+        controller(sensor, 20000.0, 200000.0, 0.1, 3, min_bias, max_bias)
+    {
+        encoder.set_batch_duration(1000);
+        *sensor > encoder > controller;
+    }
+
+    std::shared_ptr<DVSSimulatedSensor> sensor;
+    DVSEncoder encoder;
+    DVSBiasController controller;
+};
+
+static bool in_band(double rate)
+{
+    return rate >= 20000.0 && rate <= 200000.0;
+}
+
+static void test_converges()
+{
+    // Five times too many events: the biases go up until the rate is
+    // in the band...
+    Pipeline pipeline(1000000.0);
+    pipeline.sensor->generate(3000);
+    CHECK(pipeline.controller.get_bias_offset() > 0);
+    CHECK(in_band(pipeline.sensor->get_event_rate()));
+    CHECK(in_band(pipeline.controller.get_event_rate()));
+    CHECK(pipeline.controller.get_num_write_errors() == 0);
+
+    // ...and then stay put.
+    unsigned long num_adjustments = pipeline.controller.get_num_adjustments();
+    pipeline.sensor->generate(3000);
+    CHECK(pipeline.controller.get_num_adjustments() == num_adjustments);
+    CHECK(in_band(pipeline.controller.get_event_rate()));
+
+    // Too few events, and they come back down.
+    pipeline.sensor->set_scene_event_rate(20000.0);
+    pipeline.sensor->generate(5000);
+    CHECK(pipeline.controller.get_num_adjustments() > num_adjustments);
+    CHECK(in_band(pipeline.controller.get_event_rate()));
+}
+
+static void test_holds()
+{
+    Pipeline pipeline(100000.0);
+    pipeline.sensor->generate(1000);
+    CHECK(pipeline.controller.get_num_adjustments() == 0);
+
+    // A burst that lasts a period puts at most two periods over the
+    // band, fewer than the three it takes to act.
+    pipeline.sensor->set_scene_event_rate(1000000.0);
+    pipeline.sensor->generate(100);
+    pipeline.sensor->set_scene_event_rate(100000.0);
+    pipeline.sensor->generate(1000);
+    CHECK(pipeline.controller.get_num_adjustments() == 0);
+    CHECK(pipeline.controller.get_bias_offset() == 0);
+
+    // One that lasts, does move the biases.
+    pipeline.sensor->set_scene_event_rate(1000000.0);
+    pipeline.sensor->generate(600);
+    CHECK(pipeline.controller.get_num_adjustments() > 0);
+}
+
+static void test_clamped()
+{
+    // The biases can't go past 10, which isn't enough: they stop
+    // there, and nothing else is written.
+    Pipeline pipeline(2000000.0, 0, 10);
+    pipeline.sensor->generate(6000);
+    CHECK(pipeline.controller.get_biases() == std::vector<int>({10, 10}));
+    CHECK(pipeline.controller.get_bias_offset() == 10);
+    CHECK(pipeline.controller.get_num_adjustments() == 10);
+    CHECK(pipeline.controller.get_event_rate() > 200000.0);
+
+    pipeline.sensor->generate(2000);
+    CHECK(pipeline.controller.get_num_adjustments() == 10);
+    for (int i=0; i<DVSNumBiasRegisters; i++) {
+        CHECK(pipeline.sensor->read_register(DVSBiasSlaveAddress, DVSBiasRegisters[i]) == 10);
+    }
+}
+
+int main()
+{
+    test_converges();
+    test_holds();
+    test_clamped();
+    return 0;
+}
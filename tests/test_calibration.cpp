@@ -0,0 +1,60 @@
+#include <stdexcept>
+#include "roboflex_dvs/calibration.h"
+#include "check.h"
+
+using namespace roboflex::dvs;
+
+static bool throws(const DVSCameraCalibration& c)
+{
+    try {
+        DVSUndistortionTable table(c);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+static void test_invalid_focal_lengths()
+{
+    DVSCameraCalibration c;
+    c.fx = 0.0;
+    CHECK(throws(c));
+
+    c = DVSCameraCalibration();
+    c.fy = -400.0;
+    CHECK(throws(c));
+
+    c = DVSCameraCalibration();
+    c.new_fx = 400.0;
+    CHECK(throws(c));
+
+    c = DVSCameraCalibration();
+    c.new_fx = -400.0;
+    c.new_fy = 400.0;
+    CHECK(throws(c));
+}
+
+// With no distortion and no new projection, every pixel maps to itself.
+static void test_identity()
+{
+    DVSCameraCalibration c;
+    c.fx = 400.0;
+    c.fy = 400.0;
+    DVSUndistortionTable table(c);
+    CHECK(table.get_num_valid() == 320 * 480);
+
+    for (int x=0; x<320; x+=7) {
+        for (int y=0; y<480; y+=11) {
+            unsigned short ox, oy;
+            CHECK(table.lookup(x, y, ox, oy));
+            CHECK(ox == x && oy == y);
+        }
+    }
+}
+
+int main()
+{
+    test_invalid_focal_lengths();
+    test_identity();
+    return 0;
+}
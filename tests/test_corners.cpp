@@ -0,0 +1,101 @@
+#include "roboflex_dvs/corners.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+// Keeps the corners of the last message, and counts messages.
+class CornerSink: public core::Node {
+public:
+    CornerSink(): core::Node("CornerSink") {}
+
+    void receive(core::MessagePtr m) override {
+        corners = DVSCornerData(*m).get_corners();
+        num_messages++;
+    }
+
+    DVSEigenData::DVSFrame corners;
+    int num_messages = 0;
+};
+
+static const int X = 100;
+static const int Y = 200;
+
+// Sends one batch of on events at (X + dx, Y + dy) for each offset that passes keep.
+template <typename Keep>
+static void send(DVSCornerDetector& detector, double t, Keep keep)
+{
+    std::vector<unsigned short> on;
+    for (int dx=-4; dx<=4; dx++) {
+        for (int dy=-4; dy<=4; dy++) {
+            if (keep(dx, dy)) {
+                on.push_back(X + dx);
+                on.push_back(Y + dy);
+            }
+        }
+    }
+    detector.receive(std::make_shared<DVSEigenData>(on.data(), on.size() / 2, nullptr, 0, t, 0.0, 0.0));
+}
+
+// Everything around (X, Y) fires once, then a quadrant fires again: the newest
+// timestamps form a 90 degree arc on both circles, so (X, Y) is a corner.
+static void test_quadrant_is_corner()
+{
+    auto detector = std::make_shared<DVSCornerDetector>(100.0);
+    auto sink = std::make_shared<CornerSink>();
+    *detector > *sink;
+
+    send(*detector, 1000, [](int, int) { return true; });
+    send(*detector, 2000, [](int dx, int dy) { return dx > 0 && dy > 0; });
+
+    int num_messages = sink->num_messages;
+    send(*detector, 3000, [](int dx, int dy) { return dx == 0 && dy == 0; });
+    CHECK(sink->num_messages == num_messages + 1);
+    CHECK(sink->corners.rows() == 1);
+    CHECK(sink->corners(0, 0) == X && sink->corners(0, 1) == Y);
+}
+
+// A straight edge covers half of each circle, which is too long an arc.
+static void test_edge_is_not_corner()
+{
+    auto detector = std::make_shared<DVSCornerDetector>(100.0);
+    auto sink = std::make_shared<CornerSink>();
+    *detector > *sink;
+
+    send(*detector, 1000, [](int, int) { return true; });
+    send(*detector, 2000, [](int dx, int) { return dx > 0; });
+
+    int num_messages = sink->num_messages;
+    unsigned long num_corners = detector->get_num_corners();
+    send(*detector, 3000, [](int dx, int dy) { return dx == 0 && dy == 0; });
+    CHECK(sink->num_messages == num_messages);
+    CHECK(detector->get_num_corners() == num_corners);
+}
+
+// Within the refractory period, a second event at a pixel is ignored.
+static void test_refractory()
+{
+    auto detector = std::make_shared<DVSCornerDetector>(5000.0);
+    auto sink = std::make_shared<CornerSink>();
+    *detector > *sink;
+
+    send(*detector, 1000, [](int, int) { return true; });
+    send(*detector, 10000, [](int dx, int dy) { return dx > 0 && dy > 0; });
+
+    int num_messages = sink->num_messages;
+    send(*detector, 12000, [](int dx, int dy) { return dx == 0 && dy == 0; });
+    CHECK(sink->num_messages == num_messages + 1);
+
+    num_messages = sink->num_messages;
+    send(*detector, 13000, [](int dx, int dy) { return dx == 0 && dy == 0; });
+    CHECK(sink->num_messages == num_messages);
+    CHECK(detector->get_num_events() == 81 + 16 + 1 + 1);
+}
+
+int main()
+{
+    test_quadrant_is_corner();
+    test_edge_is_not_corner();
+    test_refractory();
+    return 0;
+}
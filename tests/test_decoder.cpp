@@ -0,0 +1,82 @@
+#include <vector>
+#include "roboflex_dvs/decoder.h"
+#include "check.h"
+
+using namespace roboflex::dvs;
+
+struct Event {
+    bool pol;
+    int x, y;
+    unsigned int t;
+    bool operator==(const Event& o) const { return pol == o.pol && x == o.x && y == o.y && t == o.t; }
+};
+
+static void push_word(std::vector<uint8_t>& words, uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+    words.insert(words.end(), {b0, b1, b2, b3});
+}
+
+// 50 msec of a reference timestamp and four columns per msec, with
+// three on events each, and in the middle, a few bytes of garbage
+// that throw the words out of alignment.
+static std::vector<uint8_t> corrupted_stream()
+{
+    std::vector<uint8_t> words;
+    for (int ms=1; ms<=50; ms++) {
+        push_word(words, 0x08, 0x00, 0x00, ms);
+        for (int g=0; g<4; g++) {
+            int column = 10 + 20 * g;
+            int sub_timestamp = 200 * g;
+            push_word(words, 0x04, (sub_timestamp >> 5) & 0x1F, (sub_timestamp & 0x1F) << 3, column);
+            push_word(words, 0x80, ((ms % 60) << 2) | 1, 0x00, 0x07);
+        }
+        if (ms == 25) {
+            words.insert(words.end(), {0x7C, 0x7C, 0x7C});
+        }
+    }
+    return words;
+}
+
+// Decodes the stream in buffers of buffer_size bytes.
+static std::vector<Event> decode(const std::vector<uint8_t>& bytes, int buffer_size, DVSDecoderStats& stats)
+{
+    std::vector<Event> events;
+    DVSDecoder decoder;
+    for (size_t i=0; i<bytes.size(); i+=buffer_size) {
+        int n = std::min<size_t>(buffer_size, bytes.size() - i);
+        decoder.decode(bytes.data() + i, n, [&](bool pol, int x, int y, unsigned int t) {
+            events.push_back({pol, x, y, t});
+        });
+    }
+    stats = decoder.get_stats();
+
+    // Every byte is a word, skipped, or still carried.
+    CHECK(4 * stats.words + stats.bytes_discarded + decoder.get_num_carried() == bytes.size());
+    return events;
+}
+
+int main()
+{
+    std::vector<uint8_t> bytes = corrupted_stream();
+
+    DVSDecoderStats whole_stats;
+    std::vector<Event> whole = decode(bytes, bytes.size(), whole_stats);
+    CHECK(whole_stats.resyncs == 1);
+    CHECK(whole_stats.bytes_discarded < 64);
+
+    // It found its way back: most of the second half is there.
+    CHECK(whole.size() > 50 * 4 * 3 * 9 / 10);
+
+    // However small the buffers, it resyncs at the same byte, and
+    // decodes the same events.
+    for (int buffer_size=1; buffer_size<=8; buffer_size++) {
+        DVSDecoderStats stats;
+        std::vector<Event> events = decode(bytes, buffer_size, stats);
+        CHECK(stats.resyncs == 1);
+        CHECK(stats.bytes_discarded == whole_stats.bytes_discarded);
+        CHECK(stats.invalid_words == whole_stats.invalid_words);
+        CHECK(events == whole);
+    }
+
+    return 0;
+}
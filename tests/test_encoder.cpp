@@ -0,0 +1,115 @@
+#include <vector>
+#include "roboflex_dvs/dvs.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+class Collector: public core::Node {
+public:
+    Collector(): core::Node("Collector") {}
+
+    void receive(core::MessagePtr m) override {
+        frames.push_back(std::make_shared<DVSEigenData>(*m));
+    }
+
+    std::vector<std::shared_ptr<DVSEigenData>> frames;
+};
+
+static void push_word(std::vector<uint8_t>& words, uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+    words.insert(words.end(), {b0, b1, b2, b3});
+}
+
+// A column at reference_ms + sub_timestamp usec, with two on events.
+static void push_column(std::vector<uint8_t>& words, unsigned int sub_timestamp, unsigned int column)
+{
+    push_word(words, 0x04, (sub_timestamp >> 5) & 0x1F, ((sub_timestamp & 0x1F) << 3) | ((column >> 8) & 0x03), column & 0xFF);
+    push_word(words, 0x80, (1 << 2) | 1, 0x00, 0x03);
+}
+
+static void test_batch_duration()
+{
+    // Timestamps 5010, 5020 and 5030 usec, then 7000 to end the last frame.
+    std::vector<uint8_t> words;
+    push_word(words, 0x08, 0x00, 0x00, 0x05);
+    push_column(words, 10, 100);
+    push_column(words, 20, 101);
+    push_column(words, 30, 102);
+    push_word(words, 0x08, 0x00, 0x00, 0x07);
+    push_column(words, 0, 103);
+
+    DVSEncoder encoder;
+    encoder.set_batch_duration(15);
+    Collector collector;
+    encoder > collector;
+
+    encoder.receive(std::make_shared<DVSRawData>(1.0, 1.001, words.data(), words.size(), 3));
+
+    // 5010 and 5020 are within 15 usec of the first; 5030 isn't.
+    CHECK(collector.frames.size() == 2);
+
+    DVSBatchMetadata first = collector.frames[0]->get_metadata();
+    CHECK(first.t_first == 5010);
+    CHECK(first.t_last == 5020);
+    CHECK(first.transfer_id == 3);
+    CHECK(first.transfer_t1 == 1.001);
+    CHECK(collector.frames[0]->get_t() == 5020);
+    CHECK(collector.frames[0]->get_num_on_events() == 4);
+
+    DVSBatchMetadata second = collector.frames[1]->get_metadata();
+    CHECK(second.t_first == 5030);
+    CHECK(second.t_last == 5030);
+    CHECK(collector.frames[1]->get_num_on_events() == 2);
+
+    // Nothing was dropped, and the decoder agrees.
+    CHECK(first.dropped_bytes == 0 && second.dropped_bytes == 0);
+    CHECK(encoder.get_decoder_stats().invalid_words == 0);
+}
+
+static void test_time_goes_back()
+{
+    // Timestamps 5010, 5030, back to 5020, then 7000 to end the last frame.
+    std::vector<uint8_t> words;
+    push_word(words, 0x08, 0x00, 0x00, 0x05);
+    push_column(words, 10, 100);
+    push_column(words, 30, 101);
+    push_column(words, 20, 102);
+    push_word(words, 0x08, 0x00, 0x00, 0x07);
+    push_column(words, 0, 103);
+
+    DVSEncoder encoder;
+    encoder.set_batch_duration(1000);
+    encoder.set_interleaved(true);
+    Collector collector;
+    encoder > collector;
+
+    encoder.receive(std::make_shared<DVSRawData>(1.0, 1.001, words.data(), words.size(), 3));
+
+    // All within the batch duration, but time went back at 5020.
+    CHECK(collector.frames.size() == 2);
+
+    DVSBatchMetadata first = collector.frames[0]->get_metadata();
+    CHECK(first.t_first == 5010);
+    CHECK(first.t_last == 5030);
+    CHECK(collector.frames[0]->get_t() == 5030);
+
+    // Each event keeps its own timestamp.
+    DVSEigenData::DVSInterleavedFrame events = collector.frames[0]->get_interleaved_events();
+    CHECK(events.rows() == 4);
+    CHECK(events(0, 3) == 5010 && events(1, 3) == 5010);
+    CHECK(events(2, 3) == 5030 && events(3, 3) == 5030);
+    CHECK(events(2, 0) == 319 - 101 && events(2, 2) == 1);
+
+    DVSBatchMetadata second = collector.frames[1]->get_metadata();
+    CHECK(second.t_first == 5020);
+    CHECK(second.t_last == 5020);
+    CHECK(collector.frames[1]->get_interleaved_events()(0, 3) == 5020);
+}
+
+int main()
+{
+    test_batch_duration();
+    test_time_goes_back();
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "roboflex_dvs/event_log.h"
+#include "check.h"
+
+using namespace roboflex::dvs;
+
+// One on event at (i, i), at sensor time t and host time t0.
+static roboflex::core::MessagePtr frame(int i, double t, double t0)
+{
+    unsigned short on[2] = {(unsigned short)i, (unsigned short)i};
+    return std::make_shared<DVSEigenData>(on, 1, nullptr, 0, t, t0, t0);
+}
+
+static std::vector<int> frame_indices(const std::vector<std::shared_ptr<DVSEigenData>>& frames)
+{
+    std::vector<int> indices;
+    for (auto& f: frames) {
+        indices.push_back(f->get_on_events()(0, 0));
+    }
+    return indices;
+}
+
+static void test_wrap(const std::string& filename)
+{
+    // Ten frames a msec apart, the sensor clock wrapping after the fifth.
+    const double log_t0 = DVSTimestampWrap - 5000;
+    {
+        DVSEventLogWriter writer(filename, 2);
+        for (int i=0; i<10; i++) {
+            double log_t = log_t0 + i * 1000;
+            writer.receive(frame(i, std::fmod(log_t, DVSTimestampWrap), 100 + i * 0.001));
+        }
+        writer.close();
+        CHECK(writer.get_num_wraps() == 1);
+        CHECK(writer.get_num_discontinuities() == 0);
+        CHECK(writer.get_num_blocks() == 5);
+    }
+
+    DVSEventLog log(filename);
+    CHECK(log.get_t_begin() == log_t0);
+    CHECK(log.get_t_end() == log_t0 + 9000);
+
+    // Before the wrap, after it, and across it.
+    CHECK(frame_indices(log.query(log_t0, DVSTimestampWrap - 1000)) == std::vector<int>({0, 1, 2, 3, 4}));
+    CHECK(frame_indices(log.query(DVSTimestampWrap, DVSTimestampWrap + 4000)) == std::vector<int>({5, 6, 7, 8, 9}));
+    CHECK(frame_indices(log.query(DVSTimestampWrap - 2000, DVSTimestampWrap + 1000)) == std::vector<int>({3, 4, 5, 6}));
+
+    auto after = log.query(DVSTimestampWrap + 2000, DVSTimestampWrap + 2000);
+    CHECK(after.size() == 1);
+    CHECK(after[0]->get_t() == DVSTimestampWrap + 2000);
+}
+
+static void test_restart(const std::string& filename)
+{
+    // The sensor restarts after three frames, and its clock starts over.
+    {
+        DVSEventLogWriter writer(filename, 2);
+        writer.receive(frame(0, 1000, 10.000));
+        writer.receive(frame(1, 2000, 10.001));
+        writer.receive(frame(2, 3000, 10.002));
+        writer.receive(frame(3, 500, 10.004));
+        writer.receive(frame(4, 1500, 10.005));
+        writer.close();
+        CHECK(writer.get_num_wraps() == 0);
+        CHECK(writer.get_num_discontinuities() == 1);
+    }
+
+    // Log time carries on by the host clock, so everything stays in order.
+    DVSEventLog log(filename);
+    auto frames = log.query(0, 1e9);
+    CHECK(frame_indices(frames) == std::vector<int>({0, 1, 2, 3, 4}));
+    CHECK(std::abs(frames[3]->get_t() - 5000) < 1e-3);
+    CHECK(std::abs(frames[4]->get_t() - 6000) < 1e-3);
+    CHECK(frame_indices(log.query(4500, 1e9)) == std::vector<int>({3, 4}));
+}
+
+static std::vector<char> read_file(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::string& filename, const std::vector<char>& bytes)
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+}
+
+template <typename Fn>
+static bool throws_runtime_error(Fn fn)
+{
+    try {
+        fn();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+static void test_corrupt(const std::string& filename)
+{
+    {
+        DVSEventLogWriter writer(filename, 2);
+        for (int i=0; i<4; i++) {
+            writer.receive(frame(i, 1000 + i * 1000, 10 + i * 0.001));
+        }
+    }
+    const std::vector<char> good = read_file(filename);
+
+    // Truncated.
+    write_file(filename, std::vector<char>(good.begin(), good.end() - 30));
+    CHECK(throws_runtime_error([&]() { DVSEventLog log(filename); }));
+
+    // A block count that would take all the memory there is.
+    std::vector<char> bytes = good;
+    uint64_t num_blocks = uint64_t(1) << 40;
+    std::memcpy(bytes.data() + bytes.size() - 16, &num_blocks, sizeof(num_blocks));
+    write_file(filename, bytes);
+    CHECK(throws_runtime_error([&]() { DVSEventLog log(filename); }));
+
+    // A frame that says it has more events than its block holds: the
+    // first frame's num_on, after the header and t, t0, t1.
+    bytes = good;
+    uint32_t num_on = 0xFFFFFFFF;
+    std::memcpy(bytes.data() + 16 + 3 * sizeof(double), &num_on, sizeof(num_on));
+    write_file(filename, bytes);
+    DVSEventLog log(filename);
+    CHECK(throws_runtime_error([&]() { log.query(0, 1e9); }));
+}
+
+static void test_write_failure()
+{
+    // Nothing fits on /dev/full: the index can't be written.
+    if (!std::filesystem::exists("/dev/full")) {
+        return;
+    }
+    DVSEventLogWriter writer("/dev/full", 2);
+    writer.receive(frame(0, 1000, 10));
+    CHECK(throws_runtime_error([&]() {
+        for (int i=1; i<100000; i++) {
+            writer.receive(frame(i % 320, 1000 + i, 10 + i * 1e-6));
+        }
+        writer.close();
+    }));
+}
+
+int main()
+{
+    std::string filename = (std::filesystem::temp_directory_path() / "roboflex_dvs_test_event_log.rfdvs").string();
+
+    test_wrap(filename);
+    test_restart(filename);
+    test_corrupt(filename);
+    test_write_failure();
+
+    std::filesystem::remove(filename);
+    return 0;
+}
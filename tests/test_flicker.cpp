@@ -0,0 +1,63 @@
+#include <cmath>
+#include "roboflex_dvs/flicker.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+// Keeps the markers from the last emit.
+class MarkerSink: public core::Node {
+public:
+    MarkerSink(): core::Node("MarkerSink") {}
+
+    void receive(core::MessagePtr m) override {
+        markers = DVSFlickerMarkers(*m).get_markers();
+        num_emits += 1;
+    }
+
+    DVSFlickerMarkers::Markers markers;
+    int num_emits = 0;
+};
+
+// A 3x3 LED around (101, 201) that turns on every millisecond.
+static void blink(DVSFlickerDetector& detector, double t0, int num_blinks)
+{
+    unsigned short on[18];
+    for (int i=0; i<9; i++) {
+        on[2 * i] = 100 + i / 3;
+        on[2 * i + 1] = 200 + i % 3;
+    }
+    for (int k=0; k<num_blinks; k++) {
+        detector.receive(std::make_shared<DVSEigenData>(on, 9, nullptr, 0, t0 + k * 1000, 0.0, 0.0));
+    }
+}
+
+static bool found_led(const MarkerSink& sink)
+{
+    return sink.markers.rows() == 1
+        && sink.markers(0, 0) == 0
+        && std::abs(sink.markers(0, 1) - 101) < 0.5
+        && std::abs(sink.markers(0, 2) - 201) < 0.5
+        && std::abs(sink.markers(0, 3) - 1000) < 10;
+}
+
+int main()
+{
+    // Emits every 10 msec of sensor time.
+    DVSFlickerDetector detector(30.0, {1000.0}, 50.0, 5000.0, 0.1, 3, 8, 3, 10000);
+    MarkerSink sink;
+    detector > sink;
+
+    // Just before sensor time wraps.
+    blink(detector, 4190000000.0, 30);
+    CHECK(sink.num_emits > 0);
+    CHECK(found_led(sink));
+
+    // Sensor time starts over: the LED is found again.
+    int num_emits = sink.num_emits;
+    blink(detector, 1000, 30);
+    CHECK(sink.num_emits > num_emits);
+    CHECK(found_led(sink));
+
+    return 0;
+}
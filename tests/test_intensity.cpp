@@ -0,0 +1,41 @@
+#include <cmath>
+#include "roboflex_dvs/intensity.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+static core::MessagePtr on_event(unsigned short x, unsigned short y, double t)
+{
+    unsigned short on[2] = {x, y};
+    return std::make_shared<DVSEigenData>(on, 1, nullptr, 0, t, 0.0, 0.0);
+}
+
+static bool near(float a, float b)
+{
+    return std::abs(a - b) < 1e-4;
+}
+
+int main()
+{
+    // contrast_threshold 0.1, decay_rate 2 per second.
+    DVSIntensityReconstructor reconstructor(24.0, 0.1, 2.0);
+
+    reconstructor.receive(on_event(1, 1, 1e6));
+    CHECK(near(reconstructor.get_log_intensity()(1, 1), 0.1f));
+
+    // Sensor time jumps back by almost a second: nothing blows up...
+    reconstructor.receive(on_event(1, 1, 1000));
+    float l = reconstructor.get_log_intensity()(1, 1);
+    CHECK(std::isfinite(l));
+    CHECK(near(l, 0.2f));
+
+    // ...and decay carries on from the new time: half a second later,
+    // the pixel has decayed by exp(-2 * 0.5).
+    reconstructor.receive(on_event(2, 2, 1000 + 500000));
+    DVSIntensityReconstructor::LogIntensity log_intensity = reconstructor.get_log_intensity();
+    CHECK(near(log_intensity(1, 1), 0.2f * std::exp(-1.0f)));
+    CHECK(near(log_intensity(2, 2), 0.1f));
+
+    return 0;
+}
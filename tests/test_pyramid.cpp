@@ -0,0 +1,109 @@
+#include <random>
+#include <stdexcept>
+#include "roboflex_dvs/pyramid.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+// Keeps the last pyramid.
+class PyramidSink: public core::Node {
+public:
+    PyramidSink(): core::Node("PyramidSink") {}
+
+    void receive(core::MessagePtr m) override {
+        pyramid = std::make_shared<DVSEventPyramidData>(*m);
+    }
+
+    std::shared_ptr<DVSEventPyramidData> pyramid;
+};
+
+// A batch of random on and off events, including the corners of the sensor.
+static core::MessagePtr random_batch(std::mt19937& rng, int n, double t)
+{
+    std::uniform_int_distribution<int> xs(0, 319), ys(0, 479);
+    std::vector<unsigned short> on, off;
+    for (int i=0; i<n; i++) {
+        std::vector<unsigned short>& v = (i % 3 == 0) ? off : on;
+        v.push_back(xs(rng));
+        v.push_back(ys(rng));
+    }
+    for (unsigned short x: {0, 319}) {
+        for (unsigned short y: {0, 479}) {
+            on.push_back(x);
+            on.push_back(y);
+        }
+    }
+    return std::make_shared<DVSEigenData>(on.data(), on.size() / 2, off.data(), off.size() / 2, t, 0.0, 0.0);
+}
+
+// Each cell at level l holds the sum of its 2^l x 2^l block at level 0.
+static void test_levels_sum_to_level0()
+{
+    auto pyramid = std::make_shared<DVSEventPyramid>(24.0, 0xF, 1000.0);
+    auto sink = std::make_shared<PyramidSink>();
+    *pyramid > *sink;
+
+    std::mt19937 rng(7);
+    pyramid->receive(random_batch(rng, 5000, 100));
+    pyramid->receive(random_batch(rng, 5000, 500));
+    CHECK(sink->pyramid == nullptr);
+    pyramid->receive(random_batch(rng, 10, 1500));
+    CHECK(sink->pyramid != nullptr);
+    CHECK(sink->pyramid->get_t() == 1000);
+
+    const DVSEventPyramidData::CountImage level0 = sink->pyramid->get_level(0);
+    CHECK(level0.rows() == 320 && level0.cols() == 480);
+    CHECK(level0.cast<int>().sum() == 2 * (5000 + 4));
+
+    for (int l=1; l<NumPyramidLevels; l++) {
+        const DVSEventPyramidData::CountImage level = sink->pyramid->get_level(l);
+        CHECK(level.rows() == (320 >> l) && level.cols() == (480 >> l));
+        int s = 1 << l;
+        bool all_match = true;
+        for (int r=0; r<level.rows(); r++) {
+            for (int c=0; c<level.cols(); c++) {
+                int expected = level0.block(r * s, c * s, s, s).cast<int>().sum();
+                all_match = all_match && level(r, c) == expected;
+            }
+        }
+        CHECK(all_match);
+    }
+
+    // The counts start over after each emit.
+    pyramid->receive(random_batch(rng, 10, 2500));
+    CHECK(sink->pyramid->get_t() == 2000);
+    CHECK(sink->pyramid->get_level(0).cast<int>().sum() == 10 + 4);
+    CHECK(sink->pyramid->get_level(3).cast<int>().sum() == 10 + 4);
+}
+
+// Only the levels in the mask are published.
+static void test_level_mask()
+{
+    auto pyramid = std::make_shared<DVSEventPyramid>(24.0, 0x5, 1000.0);
+    auto sink = std::make_shared<PyramidSink>();
+    *pyramid > *sink;
+
+    std::mt19937 rng(11);
+    pyramid->receive(random_batch(rng, 100, 100));
+    pyramid->receive(random_batch(rng, 10, 1500));
+
+    CHECK(sink->pyramid->has_level(0) && !sink->pyramid->has_level(1));
+    CHECK(sink->pyramid->has_level(2) && !sink->pyramid->has_level(3));
+    CHECK(sink->pyramid->get_level(2).cast<int>().sum() == sink->pyramid->get_level(0).cast<int>().sum());
+
+    bool threw = false;
+    try {
+        sink->pyramid->get_level(1);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main()
+{
+    test_levels_sum_to_level0();
+    test_level_mask();
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <chrono>
+#include <thread>
+#include "roboflex_dvs/rate_control.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+// A consumer that takes 10 msec over every batch.
+class SlowConsumer: public core::Node {
+public:
+    SlowConsumer(): core::Node("SlowConsumer") {}
+
+    void receive(core::MessagePtr m) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        num_received += 1;
+        dropped_events = DVSEigenData(*m).get_metadata().dropped_events;
+    }
+
+    int num_received = 0;
+    unsigned long dropped_events = 0;
+};
+
+// One on event and one off event.
+static core::MessagePtr batch(unsigned int t, double transfer_t1)
+{
+    unsigned short on[2] = {1, 2};
+    unsigned short off[2] = {3, 4};
+    DVSBatchMetadata metadata;
+    metadata.t_first = metadata.t_last = t;
+    metadata.transfer_t1 = transfer_t1;
+
+    // As the encoder does, t0 and t1 are when the batch was built.
+    double now = core::get_current_time();
+    return std::make_shared<DVSEigenData>(on, 1, off, 1, t, now, now, metadata);
+}
+
+static void test_back_to_back(DegradationPolicy policy)
+{
+    // Ten batches decoded out of a single transfer, back to back: each
+    // one waits for the consumer to finish the ones before it.
+    DVSRateController controller(policy, 0.025);
+    SlowConsumer consumer;
+    controller > consumer;
+
+    double transfer_t1 = core::get_current_time();
+    for (int i=0; i<10; i++) {
+        controller.receive(batch(1000 + i, transfer_t1));
+    }
+
+    DVSRateControllerMetrics metrics = controller.get_metrics();
+    CHECK(metrics.batches_in == 10);
+    CHECK(metrics.batches_out + metrics.batches_dropped == 10);
+    CHECK(metrics.lag >= 0.025);
+
+    if (policy == DegradationPolicy::DropOldest) {
+        // By the fourth batch, it's waited at least 30 msec.
+        CHECK(consumer.num_received >= 2 && consumer.num_received <= 3);
+        CHECK(metrics.batches_dropped == (unsigned long)(10 - consumer.num_received));
+
+        // The next batch that makes it through says how many were lost.
+        controller.receive(batch(2000, core::get_current_time()));
+        CHECK(consumer.num_received == (int)metrics.batches_out + 1);
+    } else {
+        CHECK(consumer.num_received == 10);
+        CHECK(metrics.degrading);
+    }
+
+    // Downstream sees every event dropped so far.
+    metrics = controller.get_metrics();
+    CHECK(metrics.events_dropped > 0);
+    CHECK(consumer.dropped_events == metrics.events_dropped);
+}
+
+static void test_fresh_transfers()
+{
+    // A slow consumer, but every batch comes from a transfer that was
+    // just read, so nothing is waiting and nothing should be dropped.
+    DVSRateController controller(DegradationPolicy::DropOldest, 0.025);
+    SlowConsumer consumer;
+    controller > consumer;
+
+    for (int i=0; i<10; i++) {
+        controller.receive(batch(1000 + i, core::get_current_time()));
+    }
+
+    DVSRateControllerMetrics metrics = controller.get_metrics();
+    CHECK(metrics.batches_dropped == 0);
+    CHECK(consumer.num_received == 10);
+}
+
+int main()
+{
+    test_back_to_back(DegradationPolicy::DropOldest);
+    test_back_to_back(DegradationPolicy::DropPolarity);
+    test_fresh_transfers();
+    return 0;
+}
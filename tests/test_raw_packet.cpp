@@ -0,0 +1,73 @@
+#include <vector>
+#include "roboflex_dvs/dvs.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+class Collector: public core::Node {
+public:
+    Collector(): core::Node("Collector") {}
+
+    void receive(core::MessagePtr m) override {
+        frames.push_back(std::make_shared<DVSEigenData>(*m));
+    }
+
+    std::vector<std::shared_ptr<DVSEigenData>> frames;
+};
+
+static void push_word(std::vector<uint8_t>& words, uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+    words.insert(words.end(), {b0, b1, b2, b3});
+}
+
+// A reference timestamp, then a column with three on events, then
+// another column, later, with two off events.
+static std::vector<uint8_t> gen3_words()
+{
+    std::vector<uint8_t> words;
+    push_word(words, 0x08, 0x00, 0x00, 0x05);
+    push_word(words, 0x04, 0x00, (10 & 0x1F) << 3, 100);
+    push_word(words, 0x80, (3 << 2) | 1, 0x00, 0x07);
+    push_word(words, 0x04, 0x00, (20 & 0x1F) << 3, 200);
+    push_word(words, 0x80, (4 << 2) | 0, 0x00, 0x03);
+    return words;
+}
+
+int main()
+{
+    std::vector<uint8_t> words = gen3_words();
+    auto packet = std::make_shared<DVSRawPacket>(1.0, 1.001, words.data(), words.size(), DVSDecoderState(), 7);
+    core::MessagePtr m = packet;
+
+    DVSEncoder encoder;
+    Collector collector;
+    encoder > collector;
+
+    // The encoder decodes through the packet's own cache...
+    CHECK(!packet->is_decoded());
+    encoder.receive(m);
+    CHECK(packet->is_decoded());
+    CHECK(packet->get_events().rows() == 5);
+
+    // ...so the next consumer of the same message gets it decoded.
+    auto other = DVSRawPacket::from_message(m);
+    CHECK(other == packet);
+    CHECK(&other->get_events() == &packet->get_events());
+
+    // The first timestamp's events went out once the second one came.
+    CHECK(collector.frames.size() == 1);
+    CHECK(collector.frames[0]->get_num_on_events() == 3);
+    CHECK(collector.frames[0]->get_num_off_events() == 0);
+    CHECK(collector.frames[0]->get_transfer_id() == 7);
+
+    // A plain message, as if it came over a transport, gets a packet
+    // (and a cache) of its own, which decodes the same.
+    auto plain = std::make_shared<core::Message>(*packet);
+    auto copy = DVSRawPacket::from_message(plain);
+    CHECK(copy != packet);
+    CHECK(!copy->is_decoded());
+    CHECK(copy->get_events() == packet->get_events());
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <random>
+#include <stdexcept>
+#include "roboflex_dvs/sparse.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+// Keeps the last sparse frame.
+class SparseSink: public core::Node {
+public:
+    SparseSink(): core::Node("SparseSink") {}
+
+    void receive(core::MessagePtr m) override {
+        frame = std::make_shared<DVSSparseFrameData>(*m);
+    }
+
+    std::shared_ptr<DVSSparseFrameData> frame;
+};
+
+typedef Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> DenseCounts;
+
+// Sends n random events at time t, and adds them to the dense reference counts.
+static void send(DVSSparseFrameBuilder& builder, std::mt19937& rng, int n, double t, DenseCounts& on_ref, DenseCounts& off_ref)
+{
+    std::uniform_int_distribution<int> xs(0, 319), ys(0, 479);
+    std::vector<unsigned short> on, off;
+    for (int i=0; i<n; i++) {
+        int x = xs(rng), y = ys(rng);
+        bool is_on = i % 2 == 0;
+        (is_on ? on : off).push_back(x);
+        (is_on ? on : off).push_back(y);
+        (is_on ? on_ref : off_ref)(x, y) += 1;
+    }
+    builder.receive(std::make_shared<DVSEigenData>(on.data(), on.size() / 2, off.data(), off.size() / 2, t, 0.0, 0.0));
+}
+
+// The CSR row_ptr must agree with the COO rows, and both with the events sent.
+static void check_window(int n)
+{
+    auto builder = std::make_shared<DVSSparseFrameBuilder>(24.0, SparseLayout::Both, 1000.0);
+    auto sink = std::make_shared<SparseSink>();
+    *builder > *sink;
+
+    std::mt19937 rng(n);
+    DenseCounts on_ref = DenseCounts::Zero(320, 480), off_ref = DenseCounts::Zero(320, 480);
+    DenseCounts unused = on_ref;
+    send(*builder, rng, n, 100, on_ref, off_ref);
+    send(*builder, rng, n, 500, on_ref, off_ref);
+    send(*builder, rng, 10, 1500, unused, unused);
+
+    const DVSSparseFrameData& f = *sink->frame;
+    CHECK(f.has_coo() && f.has_csr());
+    CHECK(f.get_t() == 1000);
+
+    const DVSSparseFrameData::IndexVector rows = f.get_rows();
+    const DVSSparseFrameData::IndexVector cols = f.get_cols();
+    const DVSSparseFrameData::OffsetVector row_ptr = f.get_row_ptr();
+    const DVSSparseFrameData::CountVector on = f.get_on_counts();
+    const DVSSparseFrameData::CountVector off = f.get_off_counts();
+    const int num_active = f.get_num_active();
+
+    CHECK(num_active == ((on_ref + off_ref).array() > 0).count());
+    CHECK(rows.size() == num_active && cols.size() == num_active);
+    CHECK(row_ptr.size() == 321);
+    CHECK(row_ptr[0] == 0 && (int)row_ptr[320] == num_active);
+
+    bool rows_match = true;
+    for (int x=0; x<320; x++) {
+        rows_match = rows_match && row_ptr[x] <= row_ptr[x + 1];
+        for (uint32_t i=row_ptr[x]; i<row_ptr[x + 1]; i++) {
+            rows_match = rows_match && rows[i] == x;
+        }
+    }
+    CHECK(rows_match);
+
+    bool sorted = true, counts_match = true;
+    for (int i=0; i<num_active; i++) {
+        if (i > 0) {
+            sorted = sorted && (rows[i - 1] * 480 + cols[i - 1] < rows[i] * 480 + cols[i]);
+        }
+        counts_match = counts_match && on[i] == on_ref(rows[i], cols[i]) && off[i] == off_ref(rows[i], cols[i]);
+    }
+    CHECK(sorted);
+    CHECK(counts_match);
+
+    // The next window only holds what was sent after the emit.
+    send(*builder, rng, 10, 2500, unused, unused);
+    CHECK(sink->frame->get_t() == 2000);
+    CHECK(sink->frame->get_on_counts().cast<int>().sum() + sink->frame->get_off_counts().cast<int>().sum() == 10);
+    CHECK((int)sink->frame->get_row_ptr()[320] == sink->frame->get_num_active());
+}
+
+// Few active pixels are sorted; most of the sensor is gathered from the bitset.
+static void test_csr_matches_coo()
+{
+    check_window(500);
+    check_window(100000);
+}
+
+static void test_layouts()
+{
+    auto builder = std::make_shared<DVSSparseFrameBuilder>(24.0, SparseLayout::CSR, 1000.0);
+    auto sink = std::make_shared<SparseSink>();
+    *builder > *sink;
+
+    std::mt19937 rng(3);
+    DenseCounts on_ref = DenseCounts::Zero(320, 480), off_ref = on_ref;
+    send(*builder, rng, 100, 100, on_ref, off_ref);
+    send(*builder, rng, 100, 1500, on_ref, off_ref);
+
+    CHECK(sink->frame->has_csr() && !sink->frame->has_coo());
+    bool threw = false;
+    try {
+        sink->frame->get_rows();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main()
+{
+    test_csr_matches_coo();
+    test_layouts();
+    return 0;
+}
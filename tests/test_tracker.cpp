@@ -0,0 +1,85 @@
+#include <cmath>
+#include <stdexcept>
+#include "roboflex_dvs/tracker.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+// Keeps the tracks from the last batch that had any.
+class TrackSink: public core::Node {
+public:
+    TrackSink(): core::Node("TrackSink") {}
+
+    void receive(core::MessagePtr m) override {
+        tracks = DVSClusterTracks(*m).get_tracks();
+    }
+
+    DVSClusterTracks::Tracks tracks;
+};
+
+// A 3x3 blob of on events around (x, y), one batch per msec.
+static void blob(DVSClusterTracker& tracker, int x, int y, double t0, int num_batches)
+{
+    unsigned short on[18];
+    for (int i=0; i<9; i++) {
+        on[2 * i] = x - 1 + i / 3;
+        on[2 * i + 1] = y - 1 + i % 3;
+    }
+    for (int k=0; k<num_batches; k++) {
+        tracker.receive(std::make_shared<DVSEigenData>(on, 9, nullptr, 0, t0 + k * 1000, 0.0, 0.0));
+    }
+}
+
+static void test_invalid_sizes()
+{
+    bool threw = false;
+    try {
+        DVSClusterTracker tracker(12.0, 0);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try {
+        DVSClusterTracker tracker(0.0, 64);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+static void test_time_jumps_back()
+{
+    DVSClusterTracker tracker;
+    TrackSink sink;
+    tracker > sink;
+
+    // Just before sensor time wraps.
+    blob(tracker, 100, 100, 4190000000.0, 20);
+    CHECK(tracker.get_num_clusters() == 1);
+    CHECK(sink.tracks.rows() == 1);
+    float id = sink.tracks(0, 0);
+
+    // Sensor time starts over, with the blob where it was: it's a new
+    // track, and its activity is built up from scratch.
+    blob(tracker, 100, 100, 1000, 20);
+    CHECK(tracker.get_num_clusters() == 1);
+    CHECK(sink.tracks.rows() == 1);
+    CHECK(sink.tracks(0, 0) != id);
+    CHECK(std::isfinite(sink.tracks(0, 8)) && sink.tracks(0, 8) < 200);
+    CHECK(std::isfinite(sink.tracks(0, 3)) && std::isfinite(sink.tracks(0, 4)));
+
+    // And idle clusters are pruned against the new times: once the
+    // blob moves away, the track it left behind goes.
+    blob(tracker, 250, 400, 21000, 200);
+    CHECK(tracker.get_num_clusters() == 1);
+}
+
+int main()
+{
+    test_invalid_sizes();
+    test_time_jumps_back();
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <array>
+#include <deque>
+#include "roboflex_dvs/window.h"
+#include "check.h"
+
+using namespace roboflex;
+using namespace roboflex::dvs;
+
+typedef std::array<unsigned int, 4> Event;
+
+// Keeps what a DVSEventWindow should hold: the newest `capacity` events
+// within the window duration, oldest first.
+struct Reference {
+    Reference(double duration, size_t capacity): duration(duration), capacity(capacity) {}
+
+    double duration;
+    size_t capacity;
+    std::deque<Event> events;
+    unsigned long num_overflowed = 0;
+
+    void receive(const std::vector<unsigned short>& on, const std::vector<unsigned short>& off, unsigned int t) {
+        if (!events.empty() && t < events.back()[0]) {
+            events.clear();
+        }
+        for (int p: {1, 0}) {
+            const std::vector<unsigned short>& v = p ? on : off;
+            for (size_t i=0; i<v.size(); i+=2) {
+                events.push_back({t, v[i], v[i + 1], (unsigned int)p});
+                if (events.size() > capacity) {
+                    events.pop_front();
+                    num_overflowed++;
+                }
+            }
+        }
+        while (!events.empty() && events.front()[0] + duration < t) {
+            events.pop_front();
+        }
+    }
+};
+
+// Sends a batch with num_on and num_off events to both, numbered from *id.
+static void send(DVSEventWindow& window, Reference& ref, int num_on, int num_off, unsigned int t, int* id)
+{
+    std::vector<unsigned short> on, off;
+    for (int i=0; i<num_on + num_off; i++, (*id)++) {
+        std::vector<unsigned short>& v = i < num_on ? on : off;
+        v.push_back(*id % 320);
+        v.push_back(*id % 480);
+    }
+    window.receive(std::make_shared<DVSEigenData>(on.data(), on.size() / 2, off.data(), off.size() / 2, t, 0.0, 0.0));
+    ref.receive(on, off, t);
+}
+
+// The window's answer to [t_begin, t_end) must be the reference's.
+static bool matches(const DVSEventWindow& window, const Reference& ref, double t_begin, double t_end)
+{
+    std::vector<Event> expected;
+    for (const Event& e: ref.events) {
+        if (e[0] >= t_begin && e[0] < t_end) {
+            expected.push_back(e);
+        }
+    }
+
+    DVSEventWindowView view = window.query(t_begin, t_end);
+    if (view.size() != expected.size() || !view.is_valid()) {
+        return false;
+    }
+
+    DVSRawPacket::DVSEventList events = window.get_events(t_begin, t_end);
+    if ((size_t)events.rows() != expected.size()) {
+        return false;
+    }
+    for (size_t i=0; i<expected.size(); i++) {
+        for (int c=0; c<4; c++) {
+            if (events(i, c) != expected[i][c]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// A small ring wraps many times over; queries must span the wrap.
+static void test_wrap_and_overflow()
+{
+    DVSEventWindow window(1e9, 16);
+    Reference ref(1e9, 16);
+    int id = 0;
+
+    bool all_match = true;
+    bool saw_wrap = false;
+    for (int k=1; k<=40; k++) {
+        send(window, ref, 3, 2, 1000 * k, &id);
+        CHECK(window.get_num_events() == ref.events.size());
+        CHECK(window.get_num_overflowed() == ref.num_overflowed);
+
+        DVSEventWindowView all = window.query(0, 1e9);
+        saw_wrap = saw_wrap || all.get_spans()[1].size > 0;
+
+        all_match = all_match && matches(window, ref, 0, 1e9);
+        all_match = all_match && matches(window, ref, 1000 * k - 1500, 1000 * k);
+        all_match = all_match && matches(window, ref, 1000 * k, 1000 * k + 1);
+        all_match = all_match && matches(window, ref, 1000 * (k + 1), 1000 * (k + 2));
+    }
+    CHECK(all_match);
+    CHECK(saw_wrap);
+    CHECK(window.get_num_events() == 16);
+    CHECK(window.get_num_overflowed() == 40 * 5 - 16);
+
+    // A batch bigger than the ring keeps only its last events.
+    send(window, ref, 20, 5, 50000, &id);
+    CHECK(window.get_num_events() == 16);
+    CHECK(window.get_num_overflowed() == ref.num_overflowed);
+    CHECK(matches(window, ref, 0, 1e9));
+
+    DVSRawPacket::DVSEventList latest = window.get_latest_events(0);
+    CHECK(latest.rows() == 16);
+    CHECK(latest(15, 3) == 0 && latest(0, 3) == 1);
+}
+
+// Events older than the window duration expire; going back in time starts over.
+static void test_expiry()
+{
+    DVSEventWindow window(2500, 64);
+    Reference ref(2500, 64);
+    int id = 0;
+
+    for (int k=1; k<=10; k++) {
+        send(window, ref, 2, 1, 1000 * k, &id);
+    }
+    CHECK(window.get_num_events() == 3 * 3);
+    CHECK(window.get_num_overflowed() == 0);
+    CHECK(matches(window, ref, 0, 1e9));
+    CHECK(window.query_latest(1000).size() == 2 * 3);
+
+    send(window, ref, 2, 1, 500, &id);
+    CHECK(window.get_num_events() == 3);
+    CHECK(matches(window, ref, 0, 1e9));
+}
+
+int main()
+{
+    test_wrap_and_overflow();
+    test_expiry();
+    return 0;
+}